@@ -438,3 +438,60 @@ redim a(10)    : if a != [0,1,2,3,4,5,6,7,8,9,10] then throw str(a)
 redim a(0 to 7): if a != [0,1,2,3,4,5,6,7] then throw str(a)
 redim a(0 to 1): if a != [0,1] then throw str(a)
 
+
+'
+' simple indexes
+'
+dim g(2, 3)
+r = 1: c = 2.7: ri = -1
+g(r, c) = 12: g(2, 3) = 23
+if g(1, 2) != 12 or g(r + 1, 3) != 23 then throw str(g)
+if g(r, 2) != g(1, c) then throw str(g)
+try
+  g(ri, 0) = 1
+  throw "out of range"
+catch e
+  if instr(e, "out of range") == 0 then throw e
+end try
+
+'
+' SORT
+'
+a = [5, -3, 9, 0, 9, -1000000000000, 2]
+sort a: if a != [-1000000000000, -3, 0, 2, 5, 9, 9] then throw str(a)
+a = [2.5, -0.5, 1e10, -1e-10, 0.0, 2.25]
+sort a: if a != [-0.5, -1e-10, 0, 2.25, 2.5, 1e10] then throw str(a)
+a = ["pear", "apple pie", "apple", "", "Apple", "apples and pears", "apples and oranges"]
+sort a: if a != ["", "Apple", "apple", "apple pie", "apples and oranges", "apples and pears", "pear"] then throw str(a)
+a = [3, "b", 1.5, "a", 2]
+sort a: if a != [1.5, 2, 3, "a", "b"] then throw str(a)
+a = [[3, 1], [1, 2], [2, 0], [1, 1]]
+sort a use x(0) - y(0): if a != [[1, 2], [1, 1], [2, 0], [3, 1]] then throw "unstable: " + str(a)
+dim a(999)
+for i = 0 to 999: a(i) = (i * 7919) mod 1000: next
+sort a
+for i = 0 to 999
+  if a(i) != i then throw "sort: " + i
+next
+for i = 0 to 999: a(i) = "/home/user/dir/file" + ((i * 7919) mod 1000) + ".bas": next
+b = a
+sort a
+sort b use iff(x < y, -1, iff(x > y, 1, 0))
+if a != b then throw "sort: shared prefix"
+
+'
+' BSEARCH
+'
+a = [1, 3, 3, 3, 7, 9]
+bsearch a, 3, i: if i != 1 then throw "bsearch: " + i
+bsearch a, 9, i: if i != 5 then throw "bsearch: " + i
+bsearch a, 4, i: if i != -1 then throw "bsearch: " + i
+bsearch a, 10, i: if i != -1 then throw "bsearch: " + i
+a = ["apple", "fig", "pear"]
+bsearch a, "fig", i: if i != 1 then throw "bsearch: " + i
+a = [30, 20, 10]
+bsearch a, 10, i use y - x: if i != 2 then throw "bsearch use: " + i
+dim a(5 to 9)
+for i = 5 to 9: a(i) = i * 2: next
+bsearch a, 16, i: if i != 8 then throw "bsearch lbound: " + i
+bsearch a, 1, i: if i != 4 then throw "bsearch lbound: " + i
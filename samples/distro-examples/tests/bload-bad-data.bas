@@ -0,0 +1,9 @@
+' BLOAD must reject array bounds which don't match the element count
+' ($, version 2, length 31, V_ARRAY, 2 dims 0..3 0..3, count 1, V_INT 7)
+open "./output.dat" for output as #1
+for x in [36, 2, 31, 0, 0, 0, 3, 2, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 1, 0, 0, 0, 0, 7, 0, 0, 0, 0, 0, 0, 0]
+  print #1, chr(x);
+next
+close #1
+bload "./output.dat", a
+print a
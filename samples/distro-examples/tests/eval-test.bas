@@ -370,6 +370,37 @@ moves_called = false
 for i in s.moves()
 next i  
 
+rem constant folding must give the same results as the runtime
+if (2*PI/360 != 0.017453292519943) then throw "fold pi"
+if (7\2 != 3 or -7 mod 3 != -1 or 7 mdl -3 != -2) then throw "fold div"
+if ((2+3)*4 != 20 or -2^2 != 4 or -(5) != -5) then throw "fold parenth"
+if (1 < 2) != 1 or (3 = 3.0000000001) != 0 then throw "fold cmp"
+const fold_n = 5
+sub fold_sub
+  if (fold_n * 2 != 200) then throw "fold const in sub"
+end
+sub fold_local
+  local fold_n = 100
+  fold_sub
+end
+fold_local
+if (fold_n * 2 != 10) then throw "fold const"
+goto fold_skip
+const fold_k = 3
+label fold_skip
+if (fold_k * 2 != 0) then throw "fold const after label"
+const fold_for = 4
+for fold_for = 1 to 2: next
+if (fold_for * 10 != 30) then throw "fold const after for"
+const fold_read = 4
+read fold_read
+if (fold_read * 10 != 10) then throw "fold const after read"
+data 1
+const fold_swap = 4
+fold_other = 1
+swap fold_swap, fold_other
+if (fold_swap * 2 != 2) then throw "fold const after swap"
+
 gg = 99
 gosub plus1
 if (gg != 100) then throw "err"
@@ -0,0 +1,9 @@
+' FOR line IN FILE(path) reads through a handle which user code can't reach
+open "./output.dat" for output as #1
+print #1, "one"
+print #1, "two"
+close #1
+for s in file("./output.dat")
+  print s
+  close #257
+next
@@ -78,3 +78,127 @@ if (B[0,2] != 5) then throw "Error TRANSPOSE()"
 if (B[1,0] != 2) then throw "Error TRANSPOSE()"
 if (B[1,1] != 4) then throw "Error TRANSPOSE()"
 if (B[1,2] != 6) then throw "Error TRANSPOSE()"
+
+rem - blocked matrix product, LU inverse and determinant
+n = 70
+dim A(n - 1, n - 1), B(n - 1, n - 2)
+for i = 0 to n - 1
+  for j = 0 to n - 1
+    A[i, j] = ((i * 7 + j * 3) mod 11) - 5 + iff(i == j, 20, 0)
+    if (j < n - 1) then B[i, j] = ((i + j * 5) mod 7) - 3
+  next
+next
+C = A * B
+for i = 0 to n - 1 step 9
+  for j = 0 to n - 2 step 7
+    s = 0
+    for k = 0 to n - 1
+      s += A[i, k] * B[k, j]
+    next
+    if (C[i, j] != s) then throw "Error matrix product"
+  next
+next
+E = inverse(A) * A
+for i = 0 to n - 1
+  for j = 0 to n - 1
+    if (abs(E[i, j] - iff(i == j, 1, 0)) > 1e-9) then throw "Error INVERSE()"
+  next
+next
+D1 = [2, 0; 0, 3]
+D2 = [0, 1; 1, 0]
+D3 = [1, 2; 2, 4]
+D4 = [2, 1, 0; 1, 3, 1; 0, 1, 4]
+D5 = [1, 1e-12; 0, 1e-12]
+if (determ(D1) != 6) then throw "Error DETERM()"
+if (determ(D2) != -1) then throw "Error DETERM() sign"
+if (determ(D3) != 0) then throw "Error DETERM() singular"
+if (determ(D4) != 18) then throw "Error DETERM() 3x3"
+D6 = [1, 2, 3; 4, 5, 6; 7, 8, 10]
+D7 = [2, 1, 0, 0; 1, 3, 1, 0; 0, 1, 4, 1; 0, 0, 1, 5]
+if (determ(D6) != -3) then throw "Error DETERM() exact 3x3"
+if (determ(D7) != 85) then throw "Error DETERM() 4x4"
+if (determ(D5, 1e-9) != 0) then throw "Error DETERM() toler"
+
+rem - element-wise operations and scalar broadcast
+v = [1, 2, 4]
+w = [2, 4, 8]
+if (str(v + 1) != "[2,3,5]") then throw "Error array + scalar"
+if (str(10 - v) != "[9,8,6]") then throw "Error scalar - array"
+if (str(v - 1) != "[0,1,3]") then throw "Error array - scalar"
+if (str(v / 2) != "[0.5,1,2]") then throw "Error array / scalar"
+if (str(w / v) != "[2,2,2]") then throw "Error array / array"
+if (str(-v) != "[-1,-2,-4]") then throw "Error -array"
+if (str(v) != "[1,2,4]") then throw "Error operand changed"
+M = [1, 2; 3, 4]
+if (str(M * 2 + M) != "[3,6;9,12]") then throw "Error matrix broadcast"
+t = ["1", 2]
+if (str(t * 2) != "[2,4]") then throw "Error string elements"
+did_fail = false
+try
+  x = v / 0
+catch
+  did_fail = true
+end try
+if (!did_fail) then throw "Error array / 0"
+
+rem - reductions over arrays
+dim big(9999)
+for i = 0 to 9999: big[i] = i + 1: next
+if (sum(big) != 50005000 || sum(big, 5) != 50005005) then throw "Error SUM()"
+if (max(big) != 10000 || min(big, -1) != -1 || max(3, big) != 10000) then throw "Error MAX()/MIN()"
+nbig = -big
+if (absmax(nbig) != 10000 || absmin(nbig) != 1) then throw "Error ABSMAX()/ABSMIN()"
+if (statmean(big) != 5000.5 || sumsq(big) != 333383335000) then throw "Error STATMEAN()/SUMSQ()"
+if (abs(statstd(big) - 2886.895679907) > 1e-6) then throw "Error STATSTD()"
+if (abs(statmeandev(big) - 2500) > 1e-9) then throw "Error STATMEANDEV()"
+if (abs(statspreadp(big) - 8333333.25) > 1e-3) then throw "Error STATSPREADP()"
+letters = ["b", "c", "a"]
+if (max(letters) != "c") then throw "Error MAX() strings"
+
+rem - median and quantiles by selection
+if (statmedian(big) != 5000.5 || statmedian(3, 1, 2) != 2) then throw "Error STATMEDIAN()"
+if (quantile(big, 0) != 1 || quantile(big, 1) != 10000 || quantile(big, 0.5) != 5000.5) then throw "Error QUANTILE()"
+q = quantile(big, [0.99, 0.5, 0.95])
+if (str(q) != "[9900.01,5000.5,9500.05]") then throw "Error QUANTILE() array"
+dup = [5, 1, 5, 5, 2, 5, 5, 9]
+if (quantile(dup, 0.25) != 4.25 || statmedian(dup) != 5) then throw "Error QUANTILE() duplicates"
+randomize 1
+dim rnd_data(1000)
+for i = 0 to 1000: rnd_data[i] = int(rnd * 100): next
+sorted = rnd_data
+sort sorted
+q = quantile(rnd_data, [0.1, 0.5, 0.9])
+if (q[0] != sorted[100] || q[1] != sorted[500] || q[2] != sorted[900]) then throw "Error QUANTILE() random"
+did_fail = false
+try
+  q = quantile(big, 1.5)
+catch
+  did_fail = true
+end try
+if (!did_fail) then throw "Error QUANTILE() range"
+
+rem - USE expressions over many points
+x = "keep"
+EXPRSEQ ua, 0, 1, 5 USE 2*x^2 - sin(x)/3 + 1
+for i = 0 to 4
+  xv = i / 4
+  if (abs(ua[i] - (2*xv^2 - sin(xv)/3 + 1)) > 1e-12) then throw "Error EXPRSEQ compiled"
+next
+k = 3
+EXPRSEQ ua, 1, 4, 4 USE -k*(x+1)
+if (str(ua) != "[-6,-9,-12,-15]") then throw "Error EXPRSEQ variable"
+EXPRSEQ ua, 1, 3, 3 USE str(x) + "!"
+if (str(ua) != "[1!,2!,3!]") then throw "Error EXPRSEQ eval"
+EXPRSEQ ua, 0, 100000, 100001 USE sqr(x)
+if (ua[0] != 0 || ua[40000] != 200 || ua[100000] != sqr(100000)) then throw "Error EXPRSEQ large"
+if (x != "keep") then throw "Error EXPRSEQ restore X"
+func use_sq(v) = v * v
+ROOT 0, 2, 500, 1e-9, ur, ue USE x^2 - 2
+if (ue != 0 || abs(ur - sqr(2)) > 1e-8) then throw "Error ROOT compiled"
+ROOT 0, 2, 500, 1e-9, ur, ue USE use_sq(x) - 2
+if (ue != 0 || abs(ur - sqr(2)) > 1e-8) then throw "Error ROOT eval"
+DERIV 1, 100, 1e-9, ud, ue USE x^3
+if (abs(ud - 3) > 1e-6) then throw "Error DERIV"
+DIFFEQN 0, 1, 1, 1000, 1e-9, uy, ue USE y
+if (ue != 0 || abs(uy - exp(1)) > 1e-8) then throw "Error DIFFEQN"
+if (x != "keep") then throw "Error ROOT restore X"
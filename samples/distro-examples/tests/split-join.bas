@@ -69,3 +69,24 @@ split s, "!@#$%^", a
 if (ubound(a) - lbound(a) != len(a) - 1) then throw "Dimension error"
 
 
+
+' grouped pairs keep their delimiters
+split "a (b c) [d e] f", " ", a, "()[]"
+if (str(a) != "[a,(b c),[d e],f]") then throw "pairs error"
+split "a,b", ",", a use upper(x)
+if (str(a) != "[A,B]") then throw "split use error"
+
+' CSVSPLIT
+q = chr(34)
+csvsplit "1," + q + "a, b" + q + "," + q + "say " + q + q + "hi" + q + q + q + ",,x", ",", a
+if (len(a) != 5 || a[1] != "a, b" || a[2] != "say " + q + "hi" + q || a[3] != "" || a[4] != "x") then throw "csvsplit error"
+csvsplit "a;b;", ";", a
+if (str(a) != "[a,b,]") then throw "csvsplit trailing error"
+csvsplit "", ",", a
+if (len(a) != 0) then throw "csvsplit empty error"
+csvsplit q + "open,x", ",", a
+if (len(a) != 1 || a[0] != "open,x") then throw "csvsplit unterminated error"
+csvsplit q + "a" + q + "b,c", ",", a
+if (str(a) != "[ab,c]") then throw "csvsplit text after quote error"
+csvsplit "a,b", ",", a use x + "!"
+if (str(a) != "[a!,b!]") then throw "csvsplit use error"
@@ -65,3 +65,119 @@ input #2; v[0], "|", v[1], "|", v[2], "|", v[3], "|", &
           v[12],"|", v[13],"|", v[14],"|", v[15],"|"
 close #2
 if v != [1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16] then throw "invalid input"
+
+' buffered output is visible to LOF, SEEK and FLUSH
+open "./output.dat" for output as #2
+print #2, "12345";
+if lof(2) != 5 then throw "invalid lof"
+if seek(2) != 5 then throw "invalid seek"
+for i = 1 to 20000
+  print #2, "abcdefghij";
+next
+flush #2
+if lof(2) != 200005 then throw "invalid lof after flush"
+close #2
+open "./output.dat" for input as #2
+seek #2, 199995
+if input(5, 2) != "abcde" then throw "invalid read after seek"
+if seek(2) != 200000 then throw "invalid seek after read"
+if eof(2) then throw "invalid eof"
+if input(5, 2) != "fghij" then throw "invalid read at end"
+if !eof(2) then throw "eof expected"
+close #2
+
+' binary WRITE and READ through the buffer
+open "./output.dat" for output as #2
+a = 1: b = "two": c = [3, 4]
+write #2, a, b, c
+a = 0: b = "": c = 0
+close #2
+open "./output.dat" for input as #2
+read #2, a, b, c
+close #2
+if a != 1 || b != "two" || c != [3, 4] then throw "invalid binary read"
+
+' TLOAD lines, CR/LF endings and a trailing newline
+open "./output.dat" for output as #2
+print #2, "one" + chr(13)
+print #2, "two"
+print #2, "three";
+close #2
+tload "./output.dat", v
+if v != ["one", "two", "three"] then throw "invalid tload"
+open "./output.dat" for append as #2
+print #2
+close #2
+tload "./output.dat", v
+if v != ["one", "two", "three", ""] then throw "invalid tload with newline"
+open "./output.dat" for input as #2
+lineinput #2, s
+tload #2, v
+close #2
+if s != "one" || v != ["two", "three", ""] then throw "invalid tload from position"
+tload "./output.dat", s, 1
+if len(s) != 15 then throw "invalid tload as string"
+open "./output2.dat" for output as #2
+close #2
+tload "./output2.dat", v
+if len(v) != 0 then throw "invalid tload of empty file"
+kill "./output2.dat"
+
+' FOR line IN FILE(path) and FOR line IN #fileN
+lines = []
+for s in file("./output.dat")
+  lines << s
+next
+if lines != ["one", "two", "three"] then throw "invalid for in file"
+open "./output.dat" for input as #2
+lineinput #2, s
+lines = []
+for s in #2
+  lines << s
+next
+if lines != ["two", "three"] || !eof(2) then throw "invalid for in #2"
+close #2
+for s in file("./output.dat")
+  exit for
+next
+if s != "one" || freefile != 1 then throw "invalid exit for in file"
+for s in file("./output.dat")
+  open "./output2.dat" for output as #1
+  print #1, s
+  close #1
+  exit for
+next
+if s != "one" then throw "invalid open #1 in for in file"
+kill "./output2.dat"
+
+' WRITE/READ and BSAVE/BLOAD of maps, NIL and typed arrays
+m = {name: "fred", age: 42, ratio: 0.5, nothing: nil}
+m.ints = [1, 2, 3]
+m.nums = [1.5, 2.5]
+m.mixed = [1, "two", {three: 3}]
+m.grid = [1, 2; 3, 4]
+m.empty = []
+m.child = {list: [{a: 1}, {b: [2, 3]}]}
+open "./output.dat" for output as #2
+write #2, m
+close #2
+open "./output.dat" for input as #2
+read #2, m2
+close #2
+if str(m2) != str(m) then throw "invalid map write/read"
+if m2.grid[1, 0] != 3 || ubound(m2.grid, 2) != 1 then throw "invalid matrix write/read"
+if m2.child.list[1].b != [2, 3] then throw "invalid nested write/read"
+bsave "./output.dat", m
+bload "./output.dat", m3
+if str(m3) != str(m) then throw "invalid bsave/bload"
+
+' FILE( after IN is always FOR line IN FILE(path), even with a variable named FILE
+open "./output.dat" for output as #1
+print #1, "one"
+close #1
+file = "./output.dat"
+lines = []
+for s in file(file)
+  lines << s
+next
+if len(lines) != 1 || lines[0] != "one" then throw "invalid for in file with a variable named file"
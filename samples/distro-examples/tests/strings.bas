@@ -215,3 +215,68 @@ REM Bug: RTRIM trimed input string on the right side
 s1 = "   test   "
 s2 = rtrim(s1)
 if(s1 != "   test   ") then throw "err: RTRIM changed input string"
+
+REM s = s + x is appended in place
+s1 = "ab"
+s1 = s1 + "cd" + 1 + chr(65)
+if (s1 != "abcd1A") then throw "err: append " + s1
+s1 = "12"
+s1 = s1 + 3
+if (s1 != 15) then throw "err: append numeric string"
+s1 = "x"
+s1 = s1 + s1
+s1 = s1 + "y" + s1
+if (s1 != "xxyxx") then throw "err: append self " + s1
+s2 = ""
+for i = 1 to 1000
+  s2 = s2 + str(i mod 10)
+next i
+if (len(s2) != 1000 || mid(s2, 991) != "1234567890") then throw "err: append loop"
+func append_s3
+  s3 = "changed"
+  append_s3 = "!"
+end
+s3 = "s3"
+s3 = s3 + append_s3()
+if (s3 != "s3!") then throw "err: append call " + s3
+
+REM INSTR, RINSTR and TRANSLATE
+s1 = "abcabcab"
+if (instr(s1, "cab") != 3 || instr(4, s1, "cab") != 6 || instr(7, s1, "cab") != 0) then throw "err: instr"
+if (rinstr(s1, "ab") != 7 || rinstr(s1, "abc") != 4 || rinstr(s1, "x") != 0) then throw "err: rinstr"
+if (rinstr(5, s1, "abc") != 0 || rinstr(4, s1, "abc") != 4 || rinstr(s1, s1) != 1) then throw "err: rinstr start"
+if (translate("aaa", "a", "bb") != "bbbbbb" || translate("abab", "ab", "") != "") then throw "err: translate"
+if (translate("x.y..z", "..", ".") != "x.y.z" || translate("abc", "", "x") != "abc") then throw "err: translate"
+if (translate("Hello HELLO hello", "hello", "bye", true) != "bye bye bye") then throw "err: translate case"
+
+REM REGEX and LIKE with regular expressions
+m = regex("2024-03-15 ERROR disk full", "([0-9]+)-([0-9]+)-([0-9]+) ([A-Z]+)")
+if (m != ["2024-03-15 ERROR", "2024", "03", "15", "ERROR"]) then throw "err: regex " + str(m)
+if (len(regex("abc", "x+")) != 0) then throw "err: regex no match"
+m = regex("ac", "a(b)?(c)")
+if (len(m) != 3 || m[1] != "" || m[2] != "c") then throw "err: regex unmatched group " + str(m)
+m = regex("a1b22c333", "[0-9]+", true)
+if (m != [["1"], ["22"], ["333"]]) then throw "err: regex all " + str(m)
+m = regex("k=v; x=y", "([a-z])=([a-z])", true)
+if (m != [["k=v", "k", "v"], ["x=y", "x", "y"]]) then throw "err: regex all groups " + str(m)
+m = regex("abc", "^.", true)
+if (str(m) != "[[a]]") then throw "err: regex all anchored " + str(m)
+if (len(regex("abc", "x*", true)) != 4) then throw "err: regex all empty"
+if ("abc" like "a*") == false then throw "err: like wildcard"
+option match pcre
+if ("abc" like "^a.c$") == false || ("abc" like "a*") == false || ("xyz" like "^a") then throw "err: like regex"
+option match pcre caseless
+if ("ABC" like "^a.c$") == false then throw "err: like caseless"
+if (str(regex("ABC", "b")) != "[B]") then throw "err: regex caseless"
+option match simple
+sub append_byref(byref p)
+  s3 = s3 + p + p
+end
+s3 = "ab"
+append_byref(s3)
+if (s3 != "ababab") then throw "err: append byref " + s3
+g = chr(65) + chr(0) + chr(66)
+h = g
+if (len(g) != 3 || len(h) != 3 || asc(mid(h, 3, 1)) != 66) then throw "err: chr(0) " + len(g) + " " + len(h)
+g = "x" + chr(0) + 1
+if (len(g) != 3 || mid(g, 3, 1) != "1") then throw "err: chr(0) + number"
@@ -20,3 +20,60 @@ repeat:i=i+1:until i>=1000000
 et=ticks
 ? "REPEAT speed: "; ((et-st)/tickspersec); "sec "; round(1000000/((et-st)/tickspersec));" l/s"
 
+' 50k lines with 10k variables, SUBs and labels
+dim src
+for i=1 to 10000
+  src << "sub p" + i + "(a)"
+  src << "  v" + i + " = a + w" + i
+  src << "end"
+  src << "label l" + i
+  src << "p" + i + " " + i
+next i
+st=ticks
+chain src
+et=ticks
+? "COMPILE speed: "; ((et-st)/tickspersec); "sec "; round(len(src)/((et-st)/tickspersec));" l/s"
+
+st=ticks
+p={}
+p.x=1:p.y=2
+for i=1 to 1000000:p.x=p.x+p.Y:next
+et=ticks
+? "FIELD speed: "; ((et-st)/tickspersec); "sec "; round(1000000/((et-st)/tickspersec));" l/s"
+
+st=ticks
+s=""
+for i=1 to 200000:s=s+"abcdefgh"+chr(65+i mod 26):next
+et=ticks
+? "APPEND speed: "; ((et-st)/tickspersec); "sec "; round(200000/((et-st)/tickspersec));" l/s"
+
+' resident memory in KB
+func rss()
+  return val(mid(run("grep VmRSS /proc/$PPID/status"), 7))
+end
+m0=rss()
+m={}
+for i=1 to 200000:m["key"+i]=i:next
+m1=rss()
+dim a(2000000)
+for i=0 to 2000000:a(i)=i/2:next
+m2=rss()
+? "MEMORY map: "; round((m1-m0)/1024, 1); "MB array: "; round((m2-m1)/1024, 1); "MB"
+
+' matrix product and inverse
+for n in [64, 256, 1024]
+  dim ma(n - 1, n - 1)
+  for i=0 to n - 1:for j=0 to n - 1:ma(i, j)=((i * 7 + j * 3) mod 11) + iff(i == j, n, 0):next:next
+  st=ticks
+  mb=ma * ma
+  et=ticks
+  mi=inverse(ma)
+  ei=ticks
+  ? "MAT "; n; " product: "; ((et-st)/tickspersec); "sec inverse: "; ((ei-et)/tickspersec); "sec"
+next
+
+' USE expressions over many points
+st=ticks
+exprseq ys, 0, 10, 1000000 use 2*x^2 - sin(x)/3 + 1
+et=ticks
+? "EXPRSEQ speed: "; ((et-st)/tickspersec); "sec "; round(1000000/((et-st)/tickspersec));" p/s"
@@ -10,6 +10,7 @@
 #include "common/bc.h"
 #include "common/smbas.h"
 #include "common/str.h"
+#include "common/hashmap.h"
 
 /*
  * string escape codes
@@ -228,6 +229,15 @@ void bc_add_strn(bc_t *bc, const char *str, int len) {
   bc_add1(bc, 0);
 }
 
+/*
+ * add a structure element name along with the hash of the name
+ */
+void bc_add_field(bc_t *bc, const char *str, int len) {
+  bc_add_code(bc, kwTYPE_UDS_EL);
+  bc_add_dword(bc, hashmap_field_hash(str, len));
+  bc_add_strn(bc, str, len);
+}
+
 /*
  * adds a string.
  * returns a pointer of src to the next "element"
@@ -98,6 +98,16 @@ void bc_add_dword(bc_t *bc, uint32_t code);
  */
 void bc_add_strn(bc_t *bc, const char *str, int len);
 
+/**
+ * @ingroup scan
+ *
+ * adds a structure element name: [kwTYPE_UDS_EL][4B-hash][kwTYPE_STR][4B-len][data]
+ *
+ * the hash is the one used by the map slots, so field access at
+ * runtime does not need to hash the name again
+ */
+void bc_add_field(bc_t *bc, const char *str, int len);
+
 /**
  * @ingroup scan
  *
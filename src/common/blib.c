@@ -57,6 +57,25 @@ void cmd_let_opt() {
   }
 }
 
+/**
+ * LET v = v + x [+ y ...]
+ */
+void cmd_let_append() {
+  var_t *v_left = code_getvarptr();
+  if (!prog_error) {
+    if (v_left->const_flag) {
+      err_const();
+    } else {
+      // skip kwTYPE_CMPOPR + "=" and the leading kwTYPE_VAR
+      code_skipopr();
+      code_skipnext();
+      code_skipaddr();
+      eval_append(v_left);
+      v_left->const_flag = 0;
+    }
+  }
+}
+
 void cmd_packed_let() {
   if (code_peek() != kwTYPE_LEVEL_BEGIN) {
     err_missing_comma();
@@ -1325,6 +1344,10 @@ int cmd_exit() {
             v_free(node.x.vfor.arr_ptr);
             v_detach(node.x.vfor.arr_ptr);
           }
+        } else if (node.x.vfor.subtype == kwFILE) {
+          if (node.x.vfor.flags & 1) {  // opened in for
+            dev_fclose_hidden(node.x.vfor.step_expr_ip);
+          }
         }
       }
       break;
@@ -1517,6 +1540,53 @@ void cmd_endif() {
 //
 // FOR [EACH] v1 IN v2
 //
+//
+// FOR line IN FILE(path) | FOR line IN #fileN
+//
+void cmd_for_in_file(stknode_t *node, bcip_t true_ip, bcip_t false_ip) {
+  int handle = 0;
+  node->x.vfor.subtype = kwFILE;
+  node->x.vfor.arr_ptr = NULL;
+
+  if (code_peek() == kwFILE) {
+    code_skipnext();
+    var_t path;
+    v_init(&path);
+    eval(&path);
+    if (!prog_error && path.type != V_STR) {
+      err_typemismatch();
+    }
+    if (!prog_error) {
+      handle = dev_fopen_hidden(path.v.p.ptr, DEV_FILE_INPUT);
+    }
+    if (!prog_error && handle) {
+      // opened here
+      node->x.vfor.flags = 1;
+    }
+    v_free(&path);
+  } else {
+    par_getsharp();
+    if (!prog_error) {
+      handle = par_getint();
+    }
+    if (!prog_error && !dev_fstatus(handle)) {
+      rt_raise(ERR_FILE_NOT_OPEN);
+    }
+  }
+
+  if (!prog_error) {
+    node->x.vfor.step_expr_ip = handle;
+    if (node->x.vfor.flags & 1 ? dev_freadln_hidden(handle, node->x.vfor.var_ptr) :
+        dev_freadln(handle, node->x.vfor.var_ptr)) {
+      code_jump(true_ip);
+    } else {
+      code_jump(false_ip);
+    }
+    stknode_t *stknode = code_push(kwFOR);
+    stknode->x.vfor = node->x.vfor;
+  }
+}
+
 void cmd_for_in(bcip_t true_ip, bcip_t false_ip, var_p_t var_p) {
   var_p_t array_p;
   code_skipnext();
@@ -1531,6 +1601,11 @@ void cmd_for_in(bcip_t true_ip, bcip_t false_ip, var_p_t var_p) {
   node.x.vfor.flags = 0;
   node.x.vfor.str_ptr = NULL;
 
+  if (code_peek() == kwFILE || code_peek() == kwTYPE_SEP) {
+    cmd_for_in_file(&node, true_ip, false_ip);
+    return;
+  }
+
   if (code_isvar()) {
     // array variable
     node.x.vfor.arr_ptr = array_p = code_getvarptr();
@@ -1840,6 +1915,26 @@ void cmd_next_for_in(stknode_t *node, bcip_t next_ip) {
   }
 }
 
+//
+// FOR line IN FILE(path) | FOR line IN #fileN
+//
+void cmd_next_for_file(stknode_t *node, bcip_t next_ip) {
+  int handle = node->x.vfor.step_expr_ip;
+  int opened = node->x.vfor.flags & 1;
+  if (opened ? dev_freadln_hidden(handle, node->x.vfor.var_ptr) :
+      dev_freadln(handle, node->x.vfor.var_ptr)) {
+    stknode_t *stknode = code_push(kwFOR);
+    stknode->x.vfor = node->x.vfor;
+    code_jump(node->x.vfor.jump_ip);
+  } else {
+    // end of file
+    if (opened) {
+      dev_fclose_hidden(handle);
+    }
+    code_jump(next_ip);
+  }
+}
+
 //
 // FOR v=exp1 TO exp2 [STEP exp3]
 //
@@ -1927,6 +2022,8 @@ void cmd_next() {
 
   if (node.x.vfor.subtype == kwTO) {
     cmd_next_for_to(&node, next_ip);
+  } else if (node.x.vfor.subtype == kwFILE) {
+    cmd_next_for_file(&node, next_ip);
   } else {
     cmd_next_for_in(&node, next_ip);
   }
@@ -2178,11 +2275,51 @@ void cmd_split() {
   cmd_wsplit();
 }
 
+/**
+ * stores the len characters from str as the element at index
+ */
+static void split_add(var_t *var_p, int index, const char *str, int len) {
+  if (v_asize(var_p) <= index) {
+    v_resize_array(var_p, index + 1);
+  }
+  var_t *elem_p = v_elem(var_p, index);
+  v_free(elem_p);
+  v_init_str(elem_p, len);
+  memcpy(elem_p->v.p.ptr, str, len);
+  elem_p->v.p.ptr[len] = '\0';
+}
+
+/**
+ * executes the USE expression for each element then jumps past the expression
+ */
+static void split_use(var_t *var_p, bcip_t use_ip, bcip_t exit_ip) {
+  if (use_ip != INVALID_ADDR) {
+    for (int i = 0; i < v_asize(var_p) && !prog_error; i++) {
+      exec_usefunc(v_elem(var_p, i), use_ip);
+    }
+    code_jump(exit_ip);
+  }
+}
+
+/**
+ * reads the optional USE expression
+ */
+static bcip_t split_get_use(bcip_t *exit_ip) {
+  bcip_t use_ip;
+  if (code_peek() == kwUSE) {
+    code_skipnext();
+    use_ip = code_getaddr();
+    *exit_ip = code_getaddr();
+  } else {
+    use_ip = INVALID_ADDR;
+  }
+  return use_ip;
+}
+
 /**
  * SPLIT string, delimiters, array() [, pairs] [USE ...]
  */
 void cmd_wsplit() {
-  char *p, *new_text;
   var_t *var_p;
   bcip_t use_ip, exit_ip = INVALID_ADDR;
   char *str = NULL, *del = NULL, *pairs = NULL;
@@ -2190,90 +2327,125 @@ void cmd_wsplit() {
   par_massget("SSPs", &str, &del, &var_p, &pairs);
 
   if (!prog_error) {
-    // is there a use keyword ?
-    if (code_peek() == kwUSE) {
-      code_skipnext();
-      use_ip = code_getaddr();
-      exit_ip = code_getaddr();
-    } else {
-      use_ip = INVALID_ADDR;
-    }
-    //
-    if (!pairs) {
-      pairs = strdup("");
-    }
+    use_ip = split_get_use(&exit_ip);
     v_toarray1(var_p, 1);
 
-    // reformat
-    new_text = strdup(str);
+    // lookup tables for the delimiters and the pairs. the first occurrence
+    // of a pairs character decides whether it opens a group, and if so the
+    // character which closes it. other pairs characters are skipped
+    char is_del[256];
+    int close_q[256];
+    memset(is_del, 0, sizeof(is_del));
+    for (int i = 0; i < 256; i++) {
+      close_q[i] = -1;
+    }
+    for (const char *d = del; *d; d++) {
+      is_del[(byte)*d] = 1;
+    }
+    if (pairs) {
+      for (int i = 0; pairs[i]; i++) {
+        if (close_q[(byte)pairs[i]] == -1) {
+          close_q[(byte)pairs[i]] = (i % 2 == 0) ? (byte)pairs[i + 1] : 0;
+        }
+      }
+    }
+
     int count = 0;
     int wait_q = 0;
-    char *ps = p = new_text;
-    char *z;
-    var_t *elem_p;
+    const char *ps = str;
+    const char *p = str;
 
     while (*p) {
-      if (wait_q == *p) {
-        wait_q = 0;
-        p++;
-      } else if (wait_q == 0 && (z = strchr(pairs, *p)) != NULL) {
-        int open_q = ((z - pairs) + 1) % 2;
-        if (open_q) {
-          wait_q = *(z + 1);
-        } else {
+      byte ch = *p;
+      if (wait_q) {
+        if (wait_q == ch) {
           wait_q = 0;
         }
-        p++;
-      } else if (wait_q == 0 && strchr(del, *p)) {
-        *p = '\0';
-
-        // add element (ps)
-        if (v_asize(var_p) <= count) {
-          // resize array
-          v_resize_array(var_p, count + 16);
-        }
-        // store string
-        elem_p = v_elem(var_p, count);
-        v_setstr(elem_p, ps);
-        count++;
-
-        // next word
-        p++;
-        ps = p;
-      } else {
-        p++;
+      } else if (close_q[ch] != -1) {
+        wait_q = close_q[ch];
+      } else if (is_del[ch]) {
+        split_add(var_p, count++, ps, p - ps);
+        ps = p + 1;
       }
+      p++;
     }
 
-    // add the last element (ps)
-    if (v_asize(var_p) <= count) {
-      v_resize_array(var_p, count + 1);
+    // add the last element, empty when the string ends with a delimiter
+    if (*ps || count) {
+      split_add(var_p, count++, ps, p - ps);
     }
-    elem_p = v_elem(var_p, count);
-    if (*ps) {
-      v_setstr(elem_p, ps);
-      count++;
-    } else if (count) {
-      v_setstr(elem_p, "");
-      count++;
+    v_resize_array(var_p, count);
+    split_use(var_p, use_ip, exit_ip);
+    pfree3(str, del, pairs);
+  }
+}
+
+/**
+ * CSVSPLIT string, delimiters, array() [USE ...]
+ *
+ * Fields starting with a double quote continue to the closing quote and may
+ * contain delimiters. Within a quoted field two double quotes give one.
+ */
+void cmd_csvsplit() {
+  var_t *var_p;
+  bcip_t use_ip, exit_ip = INVALID_ADDR;
+  char *str = NULL, *del = NULL;
+
+  par_massget("SSP", &str, &del, &var_p);
+
+  if (!prog_error) {
+    use_ip = split_get_use(&exit_ip);
+    v_toarray1(var_p, 1);
+
+    char is_del[256];
+    memset(is_del, 0, sizeof(is_del));
+    for (const char *d = del; *d; d++) {
+      is_del[(byte)*d] = 1;
     }
 
-    // final resize
-    v_resize_array(var_p, count);
+    // quoted fields are unescaped into buf, a field is never longer than the input
+    char *buf = malloc(strlen(str) + 1);
+    const char *p = str;
+    int count = 0;
 
-    // execute user's expression for each element
-    if (use_ip != INVALID_ADDR) {
-      for (int i = 0; i < v_asize(var_p) && !prog_error; i++) {
-        elem_p = v_elem(var_p, i);
-        exec_usefunc(elem_p, use_ip);
+    while (*p) {
+      const char *ps = p;
+      int len = 0;
+      if (*p == '"') {
+        p++;
+        while (*p) {
+          if (*p == '"') {
+            if (*(p + 1) != '"') {
+              p++;
+              break;
+            }
+            p++;
+          }
+          buf[len++] = *p++;
+        }
+        // text between the closing quote and the delimiter
+        while (*p && !is_del[(byte)*p]) {
+          buf[len++] = *p++;
+        }
+        split_add(var_p, count++, buf, len);
+      } else {
+        while (*p && !is_del[(byte)*p]) {
+          p++;
+        }
+        split_add(var_p, count++, ps, p - ps);
+      }
+      if (*p) {
+        // skip the delimiter, a trailing delimiter ends with an empty field
+        if (!*(++p)) {
+          split_add(var_p, count++, p, 0);
+        }
       }
-
-      // jmp to correct location
-      code_jump(exit_ip);
     }
-    // cleanup
-    pfree3(str, del, pairs);
-    free(new_text);
+
+    v_resize_array(var_p, count);
+    split_use(var_p, use_ip, exit_ip);
+    free(buf);
+    pfree2(str, del);
   }
 }
 
@@ -2528,13 +2700,477 @@ int sb_qcmp(var_t *a, var_t *b, bcip_t use_ip) {
   }
 }
 
-// using C's qsort()
-static bcip_t static_qsort_last_use_ip;
+// runs of this size are sorted by insertion before merging
+#define SORT_RUN 4
+
+// arrays of this size or more are sorted with several threads
+#define SORT_PARALLEL (1 << 18)
+
+// strings sharing a prefix in groups of this size or more are sorted by radix
+// on their next bytes, smaller groups by comparing the rest of the strings
+#define SORT_STR_GROUP 64
+#define SORT_MAX_THREADS 8
+
+// flipping the sign bit orders signed keys as unsigned
+#define SORT_SIGN 0x8000000000000000ULL
+
+typedef int (*sort_cmp_t)(const void *a, const void *b, void *ctx);
+
+/**
+ * how to sort the elements, either the array elements or keys derived
+ * from them. radix elements begin with a uint64_t key, with the compare
+ * function when given ordering the elements having the same key
+ */
+typedef struct sort_t {
+  sort_cmp_t cmp;
+  void *ctx;
+  size_t size;
+  int radix;
+} sort_t;
+
+/**
+ * string key holding the first 8 bytes in big endian order
+ */
+typedef struct sort_str_t {
+  uint64_t prefix;
+  var_t *var;
+} sort_str_t;
+
+static inline int sort_cmp(const sort_t *s, const void *a, const void *b) {
+  if (s->radix) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    if (x != y || s->cmp == NULL) {
+      return x < y ? -1 : x > y ? 1 : 0;
+    }
+  }
+  return s->cmp(a, b, s->ctx);
+}
+
+/**
+ * least significant byte radix sort, skipping the bytes shared by every key
+ */
+static void sort_radix(const sort_t *s, byte *base, byte *tmp, uint32_t count) {
+  size_t size = s->size;
+  uint32_t hist[8][256];
+  memset(hist, 0, sizeof(hist));
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t key = *(uint64_t *)(base + i * size);
+    for (int b = 0; b < 8; b++) {
+      hist[b][(key >> (b * 8)) & 0xff]++;
+    }
+  }
+
+  byte *src = base;
+  byte *dst = tmp;
+  for (int b = 0; b < 8; b++) {
+    uint32_t *pos = hist[b];
+    int shift = b * 8;
+    if (pos[(*(uint64_t *)src >> shift) & 0xff] == count) {
+      continue;
+    }
+    uint32_t sum = 0;
+    for (int i = 0; i < 256; i++) {
+      uint32_t n = pos[i];
+      pos[i] = sum;
+      sum += n;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      const byte *elem = src + i * size;
+      uint64_t key = *(const uint64_t *)elem;
+      memcpy(dst + pos[(key >> shift) & 0xff]++ * size, elem, size);
+    }
+    byte *swap = src;
+    src = dst;
+    dst = swap;
+  }
+  if (src != base) {
+    memcpy(base, src, count * size);
+  }
+}
+
+static void sort_insertion(const sort_t *s, byte *base, uint32_t count) {
+  size_t size = s->size;
+  var_t item;
+  for (uint32_t i = 1; i < count; i++) {
+    byte *next = base + i * size;
+    if (sort_cmp(s, next - size, next) > 0) {
+      uint32_t j = i;
+      memcpy(&item, next, size);
+      do {
+        memcpy(base + j * size, base + (j - 1) * size, size);
+        j--;
+      } while (j > 0 && sort_cmp(s, base + (j - 1) * size, &item) > 0);
+      memcpy(base + j * size, &item, size);
+    }
+  }
+}
+
+/**
+ * merges two sorted runs into dst, taking from the left run when equal
+ */
+static void sort_merge(const sort_t *s, const byte *left, uint32_t n1,
+                       const byte *right, uint32_t n2, byte *dst) {
+  size_t size = s->size;
+  const byte *left_end = left + n1 * size;
+  const byte *right_end = right + n2 * size;
+  while (left < left_end && right < right_end) {
+    if (sort_cmp(s, right, left) < 0) {
+      memcpy(dst, right, size);
+      right += size;
+    } else {
+      memcpy(dst, left, size);
+      left += size;
+    }
+    dst += size;
+  }
+  memcpy(dst, left, left_end - left);
+  dst += left_end - left;
+  memcpy(dst, right, right_end - right);
+}
+
+/**
+ * merge sort using tmp to hold the same number of elements
+ */
+static void sort_merge_range(const sort_t *s, byte *base, byte *tmp, uint32_t count) {
+  size_t size = s->size;
+  for (uint32_t i = 0; i < count; i += SORT_RUN) {
+    uint32_t n = count - i;
+    sort_insertion(s, base + i * size, n < SORT_RUN ? n : SORT_RUN);
+  }
+  byte *src = base;
+  byte *dst = tmp;
+  for (size_t width = SORT_RUN; width < count; width *= 2) {
+    for (size_t i = 0; i < count; i += 2 * width) {
+      uint32_t n1 = count - i < width ? count - i : width;
+      uint32_t n2 = count - i - n1 < width ? count - i - n1 : width;
+      sort_merge(s, src + i * size, n1, src + (i + n1) * size, n2, dst + i * size);
+    }
+    byte *swap = src;
+    src = dst;
+    dst = swap;
+  }
+  if (src != base) {
+    memcpy(base, src, count * size);
+  }
+}
+
+/**
+ * stable sort using tmp to hold the same number of elements
+ */
+static void sort_range(const sort_t *s, byte *base, byte *tmp, uint32_t count) {
+  if (!s->radix) {
+    sort_merge_range(s, base, tmp, count);
+    return;
+  }
+  sort_radix(s, base, tmp, count);
+  if (s->cmp != NULL) {
+    // order the elements sharing the same key
+    size_t size = s->size;
+    for (uint32_t i = 0; i < count;) {
+      uint64_t key = *(uint64_t *)(base + i * size);
+      uint32_t j = i + 1;
+      while (j < count && *(uint64_t *)(base + j * size) == key) {
+        j++;
+      }
+      if (j - i > 1) {
+        sort_merge_range(s, base + i * size, tmp, j - i);
+      }
+      i = j;
+    }
+  }
+}
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct sort_task_t {
+  const sort_t *s;
+  byte *base;
+  byte *tmp;
+  uint32_t count;
+  uint32_t n2;
+} sort_task_t;
+
+/**
+ * sorts the range, or when n2 is set merges base and the n2 elements
+ * following it into tmp
+ */
+static void *sort_thread(void *arg) {
+  sort_task_t *task = (sort_task_t *)arg;
+  if (task->n2) {
+    byte *right = task->base + task->count * task->s->size;
+    sort_merge(task->s, task->base, task->count, right, task->n2, task->tmp);
+  } else {
+    sort_range(task->s, task->base, task->tmp, task->count);
+  }
+  return NULL;
+}
+
+static void sort_run_tasks(sort_task_t *task, int count) {
+  pthread_t thread[SORT_MAX_THREADS];
+  int started[SORT_MAX_THREADS];
+  for (int i = 1; i < count; i++) {
+    started[i] = pthread_create(&thread[i], NULL, sort_thread, &task[i]) == 0;
+    if (!started[i]) {
+      sort_thread(&task[i]);
+    }
+  }
+  sort_thread(&task[0]);
+  for (int i = 1; i < count; i++) {
+    if (started[i]) {
+      pthread_join(thread[i], NULL);
+    }
+  }
+}
+
+/**
+ * sorts equal parts of the array in separate threads, then merges
+ * pairs of parts with a thread for each pair
+ */
+static int sort_parallel(const sort_t *s, byte *base, byte *tmp, uint32_t count) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int parts = 1;
+  while (parts * 2 <= cpus && parts < SORT_MAX_THREADS) {
+    parts *= 2;
+  }
+  if (parts < 2) {
+    return 0;
+  }
+
+  size_t size = s->size;
+  uint32_t start[SORT_MAX_THREADS + 1];
+  sort_task_t task[SORT_MAX_THREADS];
+  for (int p = 0; p <= parts; p++) {
+    start[p] = (uint64_t)count * p / parts;
+  }
+  for (int p = 0; p < parts; p++) {
+    task[p].s = s;
+    task[p].base = base + start[p] * size;
+    task[p].tmp = tmp + start[p] * size;
+    task[p].count = start[p + 1] - start[p];
+    task[p].n2 = 0;
+  }
+  sort_run_tasks(task, parts);
+
+  byte *src = base;
+  byte *dst = tmp;
+  for (int step = 1; step < parts; step *= 2) {
+    int n = 0;
+    for (int p = 0; p < parts; p += 2 * step, n++) {
+      task[n].base = src + start[p] * size;
+      task[n].tmp = dst + start[p] * size;
+      task[n].count = start[p + step] - start[p];
+      task[n].n2 = start[p + 2 * step] - start[p + step];
+    }
+    sort_run_tasks(task, n);
+    byte *swap = src;
+    src = dst;
+    dst = swap;
+  }
+  if (src != base) {
+    memcpy(base, src, count * size);
+  }
+  return 1;
+}
+#endif
+
+static void sort_elements(const sort_t *s, void *base, uint32_t count, int parallel) {
+  byte *tmp = malloc(count * s->size);
+  if (tmp == NULL) {
+    err_memory();
+    return;
+  }
+  int sorted = 0;
+#if defined(HAVE_PTHREAD)
+  if (parallel && count >= SORT_PARALLEL) {
+    sorted = sort_parallel(s, base, tmp, count);
+  }
+#endif
+  if (!sorted) {
+    sort_range(s, base, tmp, count);
+  }
+  free(tmp);
+}
+
+static inline uint64_t sort_num_key(var_num_t n) {
+  uint64_t bits;
+  memcpy(&bits, &n, sizeof(bits));
+  return (bits & SORT_SIGN) ? ~bits : bits | SORT_SIGN;
+}
+
+static inline var_num_t sort_num_value(uint64_t key) {
+  uint64_t bits = (key & SORT_SIGN) ? key & ~SORT_SIGN : ~key;
+  var_num_t result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+/**
+ * sorts an array of only integers or only reals by radix
+ */
+static void sort_numbers(var_t *var_p, int type) {
+  uint32_t count = v_asize(var_p);
+  var_t *data = v_data(var_p);
+  uint64_t *keys = malloc(count * sizeof(uint64_t));
+  if (keys == NULL) {
+    err_memory();
+    return;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    keys[i] = type == V_INT ? (uint64_t)data[i].v.i ^ SORT_SIGN : sort_num_key(data[i].v.n);
+  }
+  sort_t s = {NULL, NULL, sizeof(uint64_t), 1};
+  sort_elements(&s, keys, count, 1);
+  for (uint32_t i = 0; i < count; i++) {
+    if (type == V_INT) {
+      data[i].v.i = (var_int_t)(keys[i] ^ SORT_SIGN);
+    } else {
+      data[i].v.n = sort_num_value(keys[i]);
+    }
+  }
+  free(keys);
+}
+
+/**
+ * compares the rest of the strings having the same prefix
+ */
+static int sort_cmp_str(const void *a, const void *b, void *ctx) {
+  const sort_str_t *x = (const sort_str_t *)a;
+  const sort_str_t *y = (const sort_str_t *)b;
+  if ((x->prefix & 0xff) == 0) {
+    // both strings end within the prefix
+    return 0;
+  }
+  uint32_t offset = *(uint32_t *)ctx;
+  return strcmp(x->var->v.p.ptr + offset, y->var->v.p.ptr + offset);
+}
+
+/**
+ * sets the keys to the 8 bytes of the strings starting at offset
+ */
+static void sort_str_keys(sort_str_t *keys, uint32_t count, uint32_t offset) {
+  for (uint32_t i = 0; i < count; i++) {
+    const byte *str = (const byte *)keys[i].var->v.p.ptr + offset;
+    uint64_t prefix = 0;
+    for (int j = 0; j < 8 && str[j]; j++) {
+      prefix |= (uint64_t)str[j] << (56 - j * 8);
+    }
+    keys[i].prefix = prefix;
+  }
+}
+
+/**
+ * orders the strings having the same key taken at offset
+ */
+static void sort_str_groups(sort_str_t *keys, sort_str_t *tmp, uint32_t count, uint32_t offset) {
+  uint32_t next = offset + 8;
+  for (uint32_t i = 0; i < count;) {
+    uint32_t j = i + 1;
+    while (j < count && keys[j].prefix == keys[i].prefix) {
+      j++;
+    }
+    uint32_t n = j - i;
+    if (n > 1 && (keys[i].prefix & 0xff) != 0) {
+      if (n < SORT_STR_GROUP) {
+        sort_t s = {sort_cmp_str, &next, sizeof(sort_str_t), 1};
+        sort_merge_range(&s, (byte *)(keys + i), (byte *)tmp, n);
+      } else {
+        sort_t s = {NULL, NULL, sizeof(sort_str_t), 1};
+        sort_str_keys(keys + i, n, next);
+        sort_radix(&s, (byte *)(keys + i), (byte *)tmp, n);
+        sort_str_groups(keys + i, tmp, n, next);
+      }
+    }
+    i = j;
+  }
+}
+
+/**
+ * sorts an array of only strings by radix on 8 byte keys. the first keys
+ * are taken after the leading bytes shared by every string, such as the
+ * directory of a list of paths. large groups of strings sharing a key are
+ * then sorted by radix on the next 8 bytes
+ */
+static void sort_strings(var_t *var_p) {
+  uint32_t count = v_asize(var_p);
+  var_t *data = v_data(var_p);
+  sort_str_t *keys = malloc(count * sizeof(sort_str_t));
+  sort_str_t *tmp = malloc(count * sizeof(sort_str_t));
+  var_t *result = malloc(count * sizeof(var_t));
+  if (keys == NULL || tmp == NULL || result == NULL) {
+    free(keys);
+    free(tmp);
+    free(result);
+    err_memory();
+    return;
+  }
+  const char *first = data[0].v.p.ptr;
+  uint32_t skip = strlen(first);
+  for (uint32_t i = 1; i < count && skip; i++) {
+    const char *str = data[i].v.p.ptr;
+    uint32_t j = 0;
+    while (j < skip && str[j] == first[j]) {
+      j++;
+    }
+    skip = j;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    keys[i].var = &data[i];
+  }
+  sort_str_keys(keys, count, skip);
+  sort_t s = {NULL, NULL, sizeof(sort_str_t), 1};
+  sort_elements(&s, keys, count, 1);
+  sort_str_groups(keys, tmp, count, skip);
+  for (uint32_t i = 0; i < count; i++) {
+    result[i] = *keys[i].var;
+  }
+  memcpy(data, result, count * sizeof(var_t));
+  free(result);
+  free(tmp);
+  free(keys);
+}
+
+static int sort_cmp_var(const void *a, const void *b, void *ctx) {
+  return sb_qcmp((var_t *)a, (var_t *)b, *(bcip_t *)ctx);
+}
+
+/**
+ * returns the type shared by all of the elements, or V_NIL when mixed
+ */
+static int sort_type(var_t *var_p) {
+  var_t *data = v_data(var_p);
+  int result = data[0].type;
+  for (uint32_t i = 1; i < v_asize(var_p); i++) {
+    if (data[i].type != result) {
+      return V_NIL;
+    }
+  }
+  return result;
+}
 
-int qs_cmp(const void *a, const void *b) {
-  var_t *ea = (var_t *)a;
-  var_t *eb = (var_t *)b;
-  return sb_qcmp(ea, eb, static_qsort_last_use_ip);
+/**
+ * stable sort of the array elements. arrays holding a single type are
+ * sorted by key, others or when USE is given by comparing the elements
+ */
+static void sort_array(var_t *var_p, bcip_t use_ip) {
+  if (use_ip == INVALID_ADDR) {
+    int type = sort_type(var_p);
+    switch (type) {
+    case V_INT:
+    case V_NUM:
+      sort_numbers(var_p, type);
+      return;
+    case V_STR:
+      sort_strings(var_p);
+      return;
+    default:
+      break;
+    }
+  }
+  sort_t s = {sort_cmp_var, &use_ip, sizeof(var_t), 0};
+  sort_elements(&s, v_data(var_p), v_asize(var_p), 0);
 }
 
 void cmd_sort() {
@@ -2563,8 +3199,7 @@ void cmd_sort() {
   // sort
   if (!errf) {
     if (v_asize(var_p) > 1) {
-      static_qsort_last_use_ip = use_ip;
-      qsort(v_data(var_p), v_asize(var_p), sizeof(var_t), qs_cmp);
+      sort_array(var_p, use_ip);
     }
   }
   // NO RTE anymore... there is no meaning on this because of empty
@@ -2574,10 +3209,33 @@ void cmd_sort() {
   }
 }
 
+/**
+ * returns the position of the first element matching the key in the
+ * sorted array, or -1
+ */
+static int search_sorted(var_t *var_p, var_t *vkey, bcip_t use_ip) {
+  uint32_t lo = 0;
+  uint32_t hi = v_asize(var_p);
+  while (lo < hi && !prog_error) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (sb_qcmp(v_elem(var_p, mid), vkey, use_ip) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  int result = -1;
+  if (lo < v_asize(var_p) && !prog_error && sb_qcmp(v_elem(var_p, lo), vkey, use_ip) == 0) {
+    result = lo;
+  }
+  return result;
+}
+
 /**
  * SEARCH A(), key, BYREF ridx [USE ...]
+ * BSEARCH A(), key, BYREF ridx [USE ...]
  */
-void cmd_search() {
+static void search_array(int sorted) {
   bcip_t use_ip, exit_ip;
   var_t *var_p, *rv_p;
   var_t vkey;
@@ -2628,7 +3286,9 @@ void cmd_search() {
     use_ip = exit_ip = INVALID_ADDR;
   }
   // search
-  if (!errf) {
+  if (!errf && sorted) {
+    rv_p->v.i = search_sorted(var_p, &vkey, use_ip) + v_lbound(var_p, 0);
+  } else if (!errf) {
     rv_p->v.i = v_lbound(var_p, 0) - 1;
     for (int i = 0; i < v_asize(var_p); i++) {
       var_t *elem_p = v_elem(var_p, i);
@@ -2653,6 +3313,14 @@ void cmd_search() {
   v_free(&vkey);
 }
 
+void cmd_search() {
+  search_array(0);
+}
+
+void cmd_bsearch() {
+  search_array(1);
+}
+
 /**
  * SWAP a, b
  */
@@ -2707,19 +3375,37 @@ void cmd_exprseq(void) {
     exit_ip = code_getaddr();
 
     if (count > 1) {
-      v_toarray1(var_p, count);
+      usefunc_t uf;
+      var_num_t *xt = malloc(sizeof(var_num_t) * count);
+      var_num_t *yt = malloc(sizeof(var_num_t) * count);
+      if (xt == NULL || yt == NULL) {
+        free(xt);
+        free(yt);
+        err_memory();
+        return;
+      }
       dx = (xmax - xmin) / (count - 1);
       x = xmin;
-      // add the entries
       for (int i = 0; i < count; i++, x += dx) {
-        var_t *elem_p = v_elem(var_p, i);
-        v_setreal(elem_p, x);
-        exec_usefunc(elem_p, use_ip);
-
-        if (prog_error) {
-          break;
+        xt[i] = x;
+      }
+      v_toarray1(var_p, count);
+      exec_usefunc_begin(&uf, use_ip, 1);
+      if (uf.op != NULL) {
+        // numeric expression, evaluate all the points then add the entries
+        exec_usefunc_vec(&uf, xt, yt, count);
+        for (int i = 0; i < count && !prog_error; i++) {
+          v_setreal(v_elem(var_p, i), yt[i]);
+        }
+      } else {
+        // add the entries
+        for (int i = 0; i < count && !prog_error; i++) {
+          exec_usefunc_call(&uf, xt[i], 0, v_elem(var_p, i));
         }
       }
+      exec_usefunc_end(&uf);
+      free(xt);
+      free(yt);
     } else {
       v_toarray1(var_p, 0);
     }
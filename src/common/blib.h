@@ -33,6 +33,7 @@ void cmd_param(void);
 int cmd_exit(void);
 void cmd_let(int);
 void cmd_let_opt();
+void cmd_let_append();
 void cmd_packed_let();
 void cmd_dim(int);
 void cmd_redim(void);
@@ -65,6 +66,7 @@ void cmd_data(void);
 void cmd_restore(void);
 void cmd_sort(void);
 void cmd_search(void);
+void cmd_bsearch(void);
 void cmd_swap(void);
 void cmd_chain(void);
 void cmd_run(int);
@@ -83,6 +85,7 @@ void cmd_ns1(long funcCode, var_t *arg, var_t *r);
 void cmd_str0(long funcCode, var_t *r);
 void cmd_split(void);
 void cmd_wsplit(void);
+void cmd_csvsplit(void);
 void cmd_wjoin(void);
 void cmd_environ(void);
 void cmd_datedmy(void);
@@ -155,6 +158,7 @@ void cmd_fread(void);
 void cmd_flineinput(void);
 void cmd_fkill(void);
 void cmd_fseek(void);
+void cmd_fflush(void);
 void cmd_filecp(int mv);
 void cmd_chdir(void);
 void cmd_mkdir(void);
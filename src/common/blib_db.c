@@ -15,6 +15,9 @@
 #include "common/blib.h"
 #include "common/messages.h"
 #include "common/fs_socket_client.h"
+#include "common/fs_stream.h"
+#include "common/hashmap.h"
+#include "include/var_map.h"
 
 #include <dirent.h>
 
@@ -24,6 +27,7 @@
 #define CHK_ERR_CLEANUP(s) if (err_handle_error(s, &file_name)) return;
 #define CHK_ERR(s) if (err_handle_error(s, NULL)) return;
 
+// version 1 header, repeated for each array element
 struct file_encoded_var {
   byte sign;     // always '$'
   byte version;  //
@@ -31,6 +35,12 @@ struct file_encoded_var {
   uint32_t size; //
 };
 
+// the version of the encoding written by WRITE # and BSAVE
+#define ENCODED_VERSION 2
+
+// array element type when the elements are of different types
+#define ENCODED_MIXED 0xFF
+
 /*
  * OPEN "file" [FOR {INPUT|OUTPUT|APPEND}] AS #fileN
  */
@@ -106,6 +116,24 @@ void cmd_fclose() {
   }
 }
 
+/*
+ * FLUSH #fileN
+ */
+void cmd_fflush() {
+  // file handle
+  par_getsharp();
+  if (!prog_error) {
+    int handle = par_getint();
+    if (!prog_error) {
+      if (dev_fstatus(handle)) {
+        dev_fflush(handle);
+      } else {
+        rt_raise("FLUSH: FILE IS NOT OPENED");
+      }
+    }
+  }
+}
+
 /*
  * SEEK #fileN, pos
  */
@@ -130,101 +158,383 @@ void cmd_fseek() {
   }
 }
 
+int read_encoded_var(int handle, var_t *var);
+
 /*
- * store a variable in binary form
+ * read a variable from the version 1 binary form, following the sign and version
  */
-void write_encoded_var(int handle, var_t *var) {
+/*
+ * returns whether the bounds give exactly count elements. an empty array
+ * may also have a single dimension with equal bounds
+ */
+static int array_bounds_ok(int maxdim, const int32_t *bounds, uint32_t count) {
+  if (maxdim < 1 || maxdim > MAXDIM) {
+    return 0;
+  }
+  if (count == 0 && maxdim == 1 && bounds[0] == bounds[1]) {
+    return 1;
+  }
+  uint64_t size = 1;
+  for (int i = 0; i < maxdim && size <= count; i++) {
+    int32_t lbound = bounds[i * 2];
+    int32_t ubound = bounds[i * 2 + 1];
+    if ((int64_t)ubound < (int64_t)lbound - 1) {
+      return 0;
+    }
+    size *= (int64_t)ubound - lbound + 1;
+  }
+  return size == count;
+}
+
+static int read_encoded_var_v1(int handle, var_t *var) {
   struct file_encoded_var fv;
 
-  fv.sign = '$';
-  fv.version = 1;
-  fv.type = var->type;
-  switch (var->type) {
+  dev_fread(handle, (byte *)&fv + 2, sizeof(struct file_encoded_var) - 2);
+  v_free(var);
+  switch (fv.type) {
   case V_INT:
-    fv.size = OS_INTSZ;
-    dev_fwrite(handle, (byte *)&fv, sizeof(struct file_encoded_var));
-    dev_fwrite(handle, (byte *)&var->v.i, fv.size);
+    var->type = V_INT;
+    dev_fread(handle, (byte *)&var->v.i, fv.size);
     break;
   case V_NUM:
-    fv.size = OS_REALSZ;
-    dev_fwrite(handle, (byte *)&fv, sizeof(struct file_encoded_var));
-    dev_fwrite(handle, (byte *)&var->v.n, fv.size);
+    var->type = V_NUM;
+    dev_fread(handle, (byte *)&var->v.n, fv.size);
     break;
   case V_STR:
-    fv.size = strlen(var->v.p.ptr);
-    dev_fwrite(handle, (byte *)&fv, sizeof(struct file_encoded_var));
-    dev_fwrite(handle, (byte *)var->v.p.ptr, fv.size);
+    var->type = V_STR;
+    var->v.p.ptr = malloc(fv.size + 1);
+    var->v.p.length = fv.size + 1;
+    var->v.p.owner = 1;
+    dev_fread(handle, (byte *)var->v.p.ptr, fv.size);
+    var->v.p.ptr[fv.size] = '\0';
     break;
-  case V_ARRAY:
-    fv.size = v_asize(var);
-    dev_fwrite(handle, (byte *)&fv, sizeof(struct file_encoded_var));
-
-    // write additional data about array
-    dev_fwrite(handle, &v_maxdim(var), 1);
-    for (int i = 0; i < v_maxdim(var); i++) {
-      dev_fwrite(handle, (byte *)&v_lbound(var, i), sizeof(int));
-      dev_fwrite(handle, (byte *)&v_ubound(var, i), sizeof(int));
+  case V_ARRAY: {
+    // read additional data about array
+    byte maxdim = 0;
+    int32_t bounds[MAXDIM * 2];
+    dev_fread(handle, &maxdim, 1);
+    if (maxdim > MAXDIM) {
+      maxdim = 0;
+    }
+    dev_fread(handle, (byte *)bounds, maxdim * 2 * sizeof(int32_t));
+    if (prog_error || !array_bounds_ok(maxdim, bounds, fv.size)) {
+      if (!prog_error) {
+        rt_raise("READ: BAD DATA");
+      }
+      return -2;
+    }
+    v_new_array(var, fv.size);
+    v_maxdim(var) = maxdim;
+    for (int i = 0; i < maxdim; i++) {
+      v_lbound(var, i) = bounds[i * 2];
+      v_ubound(var, i) = bounds[i * 2 + 1];
     }
 
     // write elements
     for (int i = 0; i < v_asize(var); i++) {
       var_t *elem = v_elem(var, i);
-      write_encoded_var(handle, elem);
+      v_init(elem);
+      read_encoded_var(handle, elem);
     }
     break;
+  }
+  default:
+    return -2;                  // unknown data-type
   };
+
+  return 0;
 }
 
 /*
- * read a variable from a binary form
+ * appends to the encoding held in the callback buffer
  */
-int read_encoded_var(int handle, var_t *var) {
-  struct file_encoded_var fv;
+static void encode_add(hashmap_cb *cb, const void *data, uint32_t len) {
+  if (cb->index + len > (uint32_t)cb->count) {
+    while (cb->index + len > (uint32_t)cb->count) {
+      cb->count <<= 1;
+    }
+    cb->buffer = realloc(cb->buffer, cb->count);
+  }
+  memcpy(cb->buffer + cb->index, data, len);
+  cb->index += len;
+}
 
-  dev_fread(handle, (byte *)&fv, sizeof(struct file_encoded_var));
-  if (fv.sign != '$') {
-    rt_raise("READ: BAD SIGNATURE");
-    return -1;                  // bad signature
+static void encode_str(hashmap_cb *cb, const var_t *var) {
+  uint32_t len = v_strlen(var);
+  encode_add(cb, &len, sizeof(len));
+  encode_add(cb, var->v.p.ptr, len);
+}
+
+static void encode_var(hashmap_cb *cb, var_t *var);
+
+static int encode_map_cb(hashmap_cb *cb, var_p_t key, var_p_t value) {
+  encode_str(cb, key);
+  encode_var(cb, value);
+  return prog_error;
+}
+
+/*
+ * returns the type shared by all of the array elements, or ENCODED_MIXED
+ */
+static byte encode_array_type(var_t *var) {
+  uint32_t size = v_asize(var);
+  byte result = size ? (v_elem(var, 0))->type : ENCODED_MIXED;
+  if (result != V_INT && result != V_NUM) {
+    result = ENCODED_MIXED;
   }
+  for (uint32_t i = 1; i < size && result != ENCODED_MIXED; i++) {
+    if ((v_elem(var, i))->type != result) {
+      result = ENCODED_MIXED;
+    }
+  }
+  return result;
+}
 
-  v_free(var);
-  switch (fv.type) {
+/*
+ * [type] followed by the value
+ */
+static void encode_var(hashmap_cb *cb, var_t *var) {
+  byte type = var->type;
+  uint32_t count;
+
+  switch (var->type) {
+  case V_REF:
+    encode_var(cb, var->v.ref);
+    return;
   case V_INT:
-    var->type = V_INT;
-    dev_fread(handle, (byte *)&var->v.i, fv.size);
+    encode_add(cb, &type, 1);
+    encode_add(cb, &var->v.i, sizeof(var_int_t));
     break;
   case V_NUM:
-    var->type = V_NUM;
-    dev_fread(handle, (byte *)&var->v.n, fv.size);
+    encode_add(cb, &type, 1);
+    encode_add(cb, &var->v.n, sizeof(var_num_t));
     break;
   case V_STR:
-    var->type = V_STR;
-    var->v.p.ptr = malloc(fv.size + 1);
-    dev_fread(handle, (byte *)var->v.p.ptr, fv.size);
-    var->v.p.ptr[fv.size] = '\0';
+    encode_add(cb, &type, 1);
+    encode_str(cb, var);
+    break;
+  case V_NIL:
+    encode_add(cb, &type, 1);
+    break;
+  case V_MAP:
+    // [count] {[key][value]}
+    count = map_is_empty(var) ? 0 : hashmap_count(var);
+    encode_add(cb, &type, 1);
+    encode_add(cb, &count, sizeof(count));
+    if (count) {
+      hashmap_foreach(var, encode_map_cb, cb);
+    }
     break;
   case V_ARRAY:
-    v_new_array(var, fv.size);
-
-    // read additional data about array
-    dev_fread(handle, &v_maxdim(var), 1);
+    // [maxdim] {[lbound][ubound]} [size] [element type] elements
+    encode_add(cb, &type, 1);
+    encode_add(cb, &v_maxdim(var), 1);
     for (int i = 0; i < v_maxdim(var); i++) {
-      dev_fread(handle, (byte *)&v_lbound(var, i), sizeof(int));
-      dev_fread(handle, (byte *)&v_ubound(var, i), sizeof(int));
+      encode_add(cb, &v_lbound(var, i), sizeof(int32_t));
+      encode_add(cb, &v_ubound(var, i), sizeof(int32_t));
+    }
+    count = v_asize(var);
+    encode_add(cb, &count, sizeof(count));
+    type = encode_array_type(var);
+    encode_add(cb, &type, 1);
+    for (uint32_t i = 0; i < count && !prog_error; i++) {
+      var_t *elem = v_elem(var, i);
+      switch (type) {
+      case V_INT:
+        // typed arrays hold just the values
+        encode_add(cb, &elem->v.i, sizeof(var_int_t));
+        break;
+      case V_NUM:
+        encode_add(cb, &elem->v.n, sizeof(var_num_t));
+        break;
+      default:
+        encode_var(cb, elem);
+        break;
+      }
     }
+    break;
+  default:
+    err_typemismatch();
+    break;
+  }
+}
 
-    // write elements
-    for (int i = 0; i < v_asize(var); i++) {
+/*
+ * store a variable in binary form: ['$'][version][length] followed by the
+ * encoded value, written with a single call
+ */
+void write_encoded_var(int handle, var_t *var) {
+  hashmap_cb cb;
+  byte header[] = {'$', ENCODED_VERSION};
+  uint32_t len = 0;
+
+  cb.count = BUFMAX;
+  cb.index = 0;
+  cb.buffer = malloc(cb.count);
+  encode_add(&cb, header, sizeof(header));
+  encode_add(&cb, &len, sizeof(len));
+  encode_var(&cb, var);
+  if (!prog_error) {
+    len = cb.index - sizeof(header) - sizeof(len);
+    memcpy(cb.buffer + sizeof(header), &len, sizeof(len));
+    dev_fwrite(handle, (byte *)cb.buffer, cb.index);
+  }
+  free(cb.buffer);
+}
+
+/*
+ * reads from the encoding held in the callback buffer
+ */
+static int decode_get(hashmap_cb *cb, void *data, uint32_t len) {
+  int result = (len <= (uint32_t)(cb->count - cb->index));
+  if (result) {
+    memcpy(data, cb->buffer + cb->index, len);
+    cb->index += len;
+  } else if (!prog_error) {
+    rt_raise("READ: BAD DATA");
+  }
+  return result;
+}
+
+static int decode_str(hashmap_cb *cb, var_t *var) {
+  uint32_t len;
+  int result = decode_get(cb, &len, sizeof(len));
+  if (result && len > (uint32_t)(cb->count - cb->index)) {
+    rt_raise("READ: BAD DATA");
+    result = 0;
+  }
+  if (result) {
+    v_init_str(var, len);
+    decode_get(cb, var->v.p.ptr, len);
+    var->v.p.ptr[len] = '\0';
+  }
+  return result;
+}
+
+static void decode_var(hashmap_cb *cb, var_t *var) {
+  byte type;
+  byte maxdim;
+  uint32_t count;
+
+  if (!decode_get(cb, &type, 1)) {
+    return;
+  }
+  switch (type) {
+  case V_INT:
+    var->type = V_INT;
+    decode_get(cb, &var->v.i, sizeof(var_int_t));
+    break;
+  case V_NUM:
+    var->type = V_NUM;
+    decode_get(cb, &var->v.n, sizeof(var_num_t));
+    break;
+  case V_STR:
+    decode_str(cb, var);
+    break;
+  case V_NIL:
+    var->type = V_NIL;
+    break;
+  case V_MAP:
+    if (!decode_get(cb, &count, sizeof(count))) {
+      break;
+    }
+    if (count > (uint32_t)(cb->count - cb->index)) {
+      rt_raise("READ: BAD DATA");
+    } else {
+      hashmap_create(var, count);
+      for (uint32_t i = 0; i < count && !prog_error; i++) {
+        var_t *key = v_new();
+        if (decode_str(cb, key)) {
+          // the map takes ownership of the key
+          decode_var(cb, hashmap_putv(var, key));
+        } else {
+          v_detach(key);
+        }
+      }
+    }
+    break;
+  case V_ARRAY:
+    if (!decode_get(cb, &maxdim, 1) || maxdim > MAXDIM) {
+      if (!prog_error) {
+        rt_raise("READ: BAD DATA");
+      }
+      break;
+    }
+    int32_t bounds[MAXDIM * 2];
+    if (!decode_get(cb, bounds, maxdim * 2 * sizeof(int32_t)) ||
+        !decode_get(cb, &count, sizeof(count)) ||
+        !decode_get(cb, &type, 1)) {
+      break;
+    }
+    if (!array_bounds_ok(maxdim, bounds, count) ||
+        count > (uint32_t)(cb->count - cb->index)) {
+      // each element needs at least one byte
+      rt_raise("READ: BAD DATA");
+      break;
+    }
+    v_new_array(var, count);
+    v_maxdim(var) = maxdim;
+    for (int i = 0; i < maxdim; i++) {
+      v_lbound(var, i) = bounds[i * 2];
+      v_ubound(var, i) = bounds[i * 2 + 1];
+    }
+    for (uint32_t i = 0; i < count && !prog_error; i++) {
       var_t *elem = v_elem(var, i);
-      v_init(elem);
-      read_encoded_var(handle, elem);
+      switch (type) {
+      case V_INT:
+        elem->type = V_INT;
+        decode_get(cb, &elem->v.i, sizeof(var_int_t));
+        break;
+      case V_NUM:
+        elem->type = V_NUM;
+        decode_get(cb, &elem->v.n, sizeof(var_num_t));
+        break;
+      default:
+        decode_var(cb, elem);
+        break;
+      }
     }
     break;
   default:
-    return -2;                  // unknown data-type
-  };
+    rt_raise("READ: BAD DATA");
+    break;
+  }
+}
 
-  return 0;
+/*
+ * read a variable from a binary form
+ */
+int read_encoded_var(int handle, var_t *var) {
+  byte header[2];
+
+  dev_fread(handle, header, sizeof(header));
+  if (header[0] != '$') {
+    rt_raise("READ: BAD SIGNATURE");
+    return -1;                  // bad signature
+  }
+  if (header[1] == 1) {
+    return read_encoded_var_v1(handle, var);
+  }
+  if (header[1] != ENCODED_VERSION) {
+    rt_raise("READ: BAD DATA");
+    return -1;
+  }
+
+  uint32_t len = 0;
+  dev_fread(handle, (byte *)&len, sizeof(len));
+  if (!prog_error) {
+    hashmap_cb cb;
+    cb.count = len;
+    cb.index = 0;
+    cb.buffer = malloc(len ? len : 1);
+    if (dev_fread(handle, (byte *)cb.buffer, len)) {
+      v_free(var);
+      v_init(var);
+      decode_var(&cb, var);
+    }
+    free(cb.buffer);
+  }
+  return prog_error ? -2 : 0;
 }
 
 /*
@@ -340,36 +650,12 @@ void cmd_read_variable(int handle) {
   } else {
     var_t *var_p = code_getvarptr();
     if (!prog_error) {
-      v_free(var_p);
-      int size = BUFMAX;
-      int index = 0;
-      byte ch;
-
-      var_p->type = V_STR;
-      var_p->v.p.ptr = malloc(size);
-
-      // READ IT
-      while (!dev_feof(handle)) {
-        dev_fread(handle, &ch, 1);
-        if (prog_error) {
-          v_free(var_p);
-          var_p->type = V_INT;
-          var_p->v.i = -1;
-          return;
-        } else if (ch == '\n') {
-          break;
-        } else if (ch != '\r') {
-          // store char
-          if (index == (size - 1)) {
-            size += BUFMAX;
-            var_p->v.p.ptr = realloc(var_p->v.p.ptr, size);
-          }
-          var_p->v.p.ptr[index] = ch;
-          index++;
-        }
+      dev_freadln(handle, var_p);
+      if (prog_error) {
+        v_free(var_p);
+        var_p->type = V_INT;
+        var_p->v.i = -1;
       }
-      var_p->v.p.ptr[index] = '\0';
-      var_p->v.p.length = index + 1;
     }
   }
 }
@@ -516,6 +802,42 @@ void cmd_mkdir() {
   v_free(&dir);
 }
 
+/*
+ * builds the array of text lines from the file contents held in memory.
+ * the lines are counted first so that the array and each line are allocated once
+ */
+static void floadln_text(var_t *array_p, const char *text, uint32_t len) {
+  const char *end = text + len;
+  uint32_t count = len ? 1 : 0;
+  for (const char *p = text; p < end && (p = memchr(p, '\n', end - p)) != NULL; p++) {
+    count++;
+  }
+
+  v_toarray1(array_p, count);
+  const char *p = text;
+  for (uint32_t i = 0; i < count; i++) {
+    const char *eol = memchr(p, '\n', end - p);
+    if (eol == NULL) {
+      eol = end;
+    }
+    uint32_t size = eol - p;
+    var_t *var_p = v_elem(array_p, i);
+    v_init_str(var_p, size);
+    char *dst = var_p->v.p.ptr;
+    for (const char *s = p; s < eol;) {
+      // copy up to the next '\r'
+      const char *cr = memchr(s, '\r', eol - s);
+      const char *next = cr != NULL ? cr : eol;
+      memcpy(dst, s, next - s);
+      dst += next - s;
+      s = next + 1;
+    }
+    *dst = '\0';
+    var_p->v.p.length = dst - var_p->v.p.ptr + 1;
+    p = eol + 1;
+  }
+}
+
 /*
  * load text-file to string or to array
  * Modified 2-May-2002 Chris Warren-Smith. Implemented buffered read
@@ -581,7 +903,18 @@ void cmd_floadln() {
     CHK_ERR(FSERR_GENERIC);
   }
 
-  if (type == 0) {
+  stream_map_t map;
+  dev_file_t *f = dev_getfileptr(handle);
+  if (type == 0 && f->type == ft_stream && stream_map(f, &map)) {
+    if (map.base == NULL) {
+      // nothing left to read, so nothing was mapped
+      v_toarray1(array_p, 0);
+    } else {
+      // build array from the memory mapped file
+      floadln_text(array_p, map.base + map.offset, map.size - map.offset);
+      stream_unmap(&map);
+    }
+  } else if (type == 0) {
     // build array
     int array_size = LDLN_INC;
     int index = 0;
@@ -954,13 +1287,66 @@ void cmd_bputc() {
 }
 
 /*
- * load from file to a memory address
+ * returns the variable following the file name in BLOAD/BSAVE file, var
+ * or NULL for the memory address forms
+ */
+static var_t *par_getbinvar(var_t *file_name) {
+  var_t *result = NULL;
+  bcip_t ip = prog_ip;
+  par_getstr(file_name);
+  if (!prog_error && code_peek() == kwTYPE_SEP) {
+    par_getcomma();
+    if (!prog_error && code_isvar()) {
+      result = code_getvarptr();
+      if (code_peek() == kwTYPE_SEP) {
+        result = NULL;
+      }
+    }
+  }
+  if (result == NULL || prog_error) {
+    v_free(file_name);
+    prog_ip = ip;
+    result = NULL;
+  }
+  return result;
+}
+
+/*
+ * load or save a variable in the binary form used by READ # and WRITE #
+ */
+static void binvar_load_save(var_t *file_name, var_t *var_p, int flags) {
+  int handle = dev_freefilehandle();
+  if (!prog_error && dev_fstatus(handle) == 0) {
+    dev_fopen(handle, file_name->v.p.ptr, flags);
+    if (!prog_error) {
+      if (flags == DEV_FILE_INPUT) {
+        read_encoded_var(handle, var_p);
+      } else {
+        write_encoded_var(handle, var_p);
+      }
+      dev_fclose(handle);
+    }
+  }
+  v_free(file_name);
+}
+
+/*
+ * load from file to a memory address or variable
  *
  * BLOAD file[, offset]
+ * BLOAD file, var
  */
 void cmd_bload() {
   var_int_t ofs = -1;
   char *fname = NULL;
+  var_t file_name;
+
+  v_init(&file_name);
+  var_t *var_p = par_getbinvar(&file_name);
+  if (var_p != NULL) {
+    binvar_load_save(&file_name, var_p, DEV_FILE_INPUT);
+    return;
+  }
 
   par_massget("Si", &fname, &ofs);
   if (!prog_error) {
@@ -992,13 +1378,22 @@ void cmd_bload() {
 }
 
 /*
- * save memory contents to a file
+ * save memory contents or a variable to a file
  *
  * BSAVE file, offset, length
+ * BSAVE file, var
  */
 void cmd_bsave() {
   var_int_t ofs = 0, len = 0;
   char *fname = NULL;
+  var_t file_name;
+
+  v_init(&file_name);
+  var_t *var_p = par_getbinvar(&file_name);
+  if (var_p != NULL) {
+    binvar_load_save(&file_name, var_p, DEV_FILE_OUTPUT);
+    return;
+  }
 
   par_massget("SII", &fname, &ofs, &len);
   if (!prog_error) {
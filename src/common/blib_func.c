@@ -19,6 +19,7 @@
 #include "common/geom.h"
 #include "common/messages.h"
 #include "common/keymap.h"
+#include "lib/match.h"
 
 // relative coordinates (current x/y) from blib_graph
 extern int gra_x;
@@ -172,6 +173,75 @@ void dar_final(long funcCode, var_t *r, int count) {
   };
 }
 
+/*
+ * ARRAY ROUTINES - All the elements of an array
+ * the same as dar_first/dar_next for each element, with the
+ * function code tested once rather than per element
+ */
+static void dar_array(long funcCode, var_t *r, var_t *array, byte *first) {
+  uint32_t count = v_asize(array);
+  uint32_t i = 0;
+
+  if (count && *first) {
+    dar_first(funcCode, r, v_elem(array, 0));
+    *first = 0;
+    i = 1;
+  }
+
+  switch (funcCode) {
+  case kwMAX:
+  case kwMIN: {
+    // remember the best element, copying it once at the end
+    var_t *best = r;
+    int sign = (funcCode == kwMAX) ? 1 : -1;
+    for (; i < count && !prog_error; i++) {
+      var_t *elem_p = v_elem(array, i);
+      if (v_compare(best, elem_p) * sign < 0) {
+        best = elem_p;
+      }
+    }
+    if (best != r) {
+      v_set(r, best);
+    }
+  }
+    break;
+  case kwABSMIN:
+    for (; i < count && !prog_error; i++) {
+      var_num_t n = fabs(v_getval(v_elem(array, i)));
+      if (n < r->v.n) {
+        r->v.n = n;
+      }
+    }
+    break;
+  case kwABSMAX:
+    for (; i < count && !prog_error; i++) {
+      var_num_t n = fabs(v_getval(v_elem(array, i)));
+      if (n > r->v.n) {
+        r->v.n = n;
+      }
+    }
+    break;
+  case kwSUM:
+  case kwSTATMEAN: {
+    var_num_t sum = r->v.n;
+    for (; i < count && !prog_error; i++) {
+      sum += v_getval(v_elem(array, i));
+    }
+    r->v.n = sum;
+  }
+    break;
+  case kwSUMSV: {
+    var_num_t sum = r->v.n;
+    for (; i < count && !prog_error; i++) {
+      var_num_t n = v_getval(v_elem(array, i));
+      sum += n * n;
+    }
+    r->v.n = sum;
+  }
+    break;
+  }
+}
+
 /*
  * DATE mm/dd/yy string to ints
  */
@@ -1771,16 +1841,15 @@ void cmd_intN(long funcCode, var_t *r) {
       if (start < 0) {
         start = 0;
       }
-      char *p = s1 + start;
+      const char *found;
       l = strlen(s2);
-      while (*p) {
-        if (strncmp(p, s2, l) == 0) {
-          r->v.i = (p - s1) + 1;
-          if (funcCode == kwINSTR) {
-            break;
-          }
-        }
-        p++;
+      if (funcCode == kwINSTR) {
+        found = memmem(s1 + start, s1_len - start, s2, l);
+      } else {
+        found = str_rfind(s1 + start, s1_len - start, s2, l);
+      }
+      if (found != NULL) {
+        r->v.i = (found - s1) + 1;
       }
     }
     break;
@@ -2026,6 +2095,112 @@ void cmd_numN(long funcCode, var_t *r) {
   }
 }
 
+//
+// n <- QUANTILE(A, p), array <- QUANTILE(A, [p1, p2, ...])
+//
+static void cmd_quantile(var_t *r) {
+  var_t *a = par_getvarray();
+  IF_ERR_RETURN;
+  if (a == NULL) {
+    err_varisnotarray();
+    return;
+  }
+  par_getcomma();
+  IF_ERR_RETURN;
+
+  var_t arg;
+  v_init(&arg);
+  eval(&arg);
+  if (!prog_error) {
+    int n = arg.type == V_ARRAY ? v_asize(&arg) : 1;
+    int count = v_asize(a);
+    var_num_t *p = (var_num_t *)malloc(sizeof(var_num_t) * n);
+    var_num_t *result = (var_num_t *)malloc(sizeof(var_num_t) * n);
+    var_num_t *e = (var_num_t *)malloc(sizeof(var_num_t) * (count ? count : 1));
+
+    for (int i = 0; i < n && !prog_error; i++) {
+      p[i] = v_getval(arg.type == V_ARRAY ? v_elem(&arg, i) : &arg);
+      if (!prog_error && !(p[i] >= 0 && p[i] <= 1)) {
+        err_out_of_range();
+      }
+    }
+    for (int i = 0; i < count && !prog_error; i++) {
+      e[i] = v_getval(v_elem(a, i));
+    }
+    if (!prog_error) {
+      statquantile(e, count, p, result, n);
+      if (arg.type == V_ARRAY) {
+        v_toarray1(r, n);
+        for (int i = 0; i < n; i++) {
+          v_setreal(v_elem(r, i), result[i]);
+        }
+      } else {
+        v_setreal(r, result[0]);
+      }
+    }
+    free(e);
+    free(result);
+    free(p);
+  }
+  v_free(&arg);
+}
+
+//
+// sets the array to the text of the matched groups
+//
+static void regex_groups(var_t *r, const char *t, reg_group_t *groups, int count) {
+  v_toarray1(r, count);
+  for (int i = 0; i < count; i++) {
+    var_t *elem_p = v_elem(r, i);
+    if (groups[i].start == -1) {
+      // the group did not take part in the match
+      v_setstr(elem_p, "");
+    } else {
+      int len = groups[i].end - groups[i].start;
+      v_init_str(elem_p, len);
+      memcpy(elem_p->v.p.ptr, t + groups[i].start, len);
+      elem_p->v.p.ptr[len] = '\0';
+    }
+  }
+}
+
+//
+// array <- REGEX(text, pattern [, all])
+//
+static void cmd_regex(var_t *r) {
+  char *text = NULL, *pattern = NULL;
+  var_int_t all = 0;
+  reg_group_t groups[REG_MATCH_GROUPS];
+
+  par_massget("SSi", &text, &pattern, &all);
+  if (!prog_error) {
+    int flags = opt_usepcre == 2 ? reg_search_caseless : 0;
+    if (!all) {
+      // the first match followed by the matched groups
+      int count = reg_search(pattern, text, flags, groups, REG_MATCH_GROUPS);
+      regex_groups(r, text, groups, count > 0 ? count : 0);
+    } else {
+      // an array for each match
+      uint32_t size = 0;
+      int offset = 0;
+      int len = strlen(text);
+      v_toarray1(r, 0);
+      while (offset <= len && !prog_error) {
+        int count = reg_search(pattern, text + offset, flags | (offset ? reg_search_notbol : 0),
+                               groups, REG_MATCH_GROUPS);
+        if (count <= 0) {
+          break;
+        }
+        v_resize_array(r, ++size);
+        regex_groups(v_elem(r, size - 1), text + offset, groups, count);
+        // continue after the match, moving forward after an empty match
+        offset += groups[0].end > groups[0].start ? groups[0].end : groups[0].end + 1;
+      }
+    }
+  }
+  pfree2(text, pattern);
+}
+
 /*
  * any <- FUNC (...)
  */
@@ -2558,21 +2733,11 @@ void cmd_genfunc(long funcCode, var_t *r) {
         if (code_isvar()) {
           var_t *basevar_p = code_getvarptr();
           if (!prog_error && basevar_p->type == V_ARRAY) {
-            count = v_asize(basevar_p);
-            for (int i = 0; i < count; i++) {
-              var_t *elem_p = v_elem(basevar_p, i);
-              if (!prog_error) {
-                if (first) {
-                  dar_first(funcCode, r, elem_p);
-                  first = 0;
-                } else {
-                  dar_next(funcCode, r, elem_p);
-                }
-                tcount++;
-              } else {
-                return;
-              }
+            dar_array(funcCode, r, basevar_p, &first);
+            if (prog_error) {
+              return;
             }
+            tcount += v_asize(basevar_p);
             break;
           }
         }
@@ -2632,19 +2797,16 @@ void cmd_genfunc(long funcCode, var_t *r) {
           var_t *basevar_p = code_getvarptr();
           if (!prog_error && basevar_p->type == V_ARRAY) {
             count = v_asize(basevar_p);
-            for (int i = 0; i < count; i++) {
-              var_t *elem_p = v_elem(basevar_p, i);
-              if (!prog_error) {
-                if (tcount >= len) {
-                  len += BUF_LEN;
-                  dar = (var_num_t*) realloc(dar, sizeof(var_num_t) * len);
-                }
-                dar[tcount] = v_getval(elem_p);
-                tcount++;
-              } else {
-                free(dar);
-                return;
-              }
+            if (tcount + count > len) {
+              len = tcount + count;
+              dar = (var_num_t*) realloc(dar, sizeof(var_num_t) * len);
+            }
+            for (int i = 0; i < count && !prog_error; i++) {
+              dar[tcount++] = v_getval(v_elem(basevar_p, i));
+            }
+            if (prog_error) {
+              free(dar);
+              return;
             }
             break;
           }
@@ -2658,7 +2820,7 @@ void cmd_genfunc(long funcCode, var_t *r) {
         eval(&arg);
         if (!prog_error) {
           if (tcount >= len) {
-            len += BUF_LEN;
+            len *= 2;
             dar = (var_num_t*) realloc(dar, sizeof(var_num_t) * len);
           }
 
@@ -2935,6 +3097,14 @@ void cmd_genfunc(long funcCode, var_t *r) {
   }
     break;
 
+  case kwREGEX:
+    cmd_regex(r);
+    break;
+
+  case kwQUANTILE:
+    cmd_quantile(r);
+    break;
+
   case kwIMAGE:
     v_create_image(r);
     break;
@@ -52,9 +52,9 @@ var_num_t fround(var_num_t x, int dig) {
   return result;
 }
 
-void root_iterate(var_num_t xl, var_num_t xh, var_num_t fl, 
-                  var_num_t fh, var_t *res_vp, var_num_t maxerr,
-                  var_t *err_vp, bcip_t use_ip);
+static void root_iterate(var_num_t xl, var_num_t xh, var_num_t fl, 
+                  var_num_t fh, var_num_t *res, var_num_t maxerr,
+                  var_int_t *err, usefunc_t *uf);
 
 /*
  * length of line
@@ -163,73 +163,125 @@ void mat_gauss_jordan(var_num_t *a, var_num_t *b, int n, double toler) {
 }
 
 /*
+ * Determinant of A. Up to 3x3 the cofactor expansion is used, so integer
+ * matrices give exact results. Otherwise it is the product of the pivots of
+ * the LU decomposition, rounded when every element of A is an integer
  */
-void mat_det2(var_num_t t, int m, int k, var_num_t *a, int *done, var_num_t *v, int n, double toler) {
-  if (k >= n) {
-    int s = -1;
+var_num_t mat_determ(var_num_t *a, int n, double toler) {
+  var_num_t v = 0;
 
-    if ((m % 2) == 0) {
-      s = 1;
-    }
-    *v += s * t;
-  } else {
-    if (ABS(t) > toler) {
-      int n2 = 0, j;
-
-      for (j = n - 1; j >= 0; j--) {
-        if (done[j]) {
-          n2++;
-        } else {
-          done[j] = 1;
-          mat_det2(t * a[k * n + j], m + n2, k + 1, a, done, v, n, toler);
-          done[j] = 0;
-        }
+  if (n == 2) {
+    v = a[0] * a[3] - a[1] * a[2];
+    return (ABS(v) <= toler) ? 0 : v;
+  }
+  if (n == 3) {
+    v = a[0] * (a[4] * a[8] - a[5] * a[7]) -
+        a[1] * (a[3] * a[8] - a[5] * a[6]) +
+        a[2] * (a[3] * a[7] - a[4] * a[6]);
+    return (ABS(v) <= toler) ? 0 : v;
+  }
+
+  int integers = 1;
+  for (int i = 0; i < n * n && integers; i++) {
+    integers = (a[i] == floor(a[i]));
+  }
+
+  int *p = malloc(n * sizeof(int));
+  int swaps = mat_lu(a, p, n);
+
+  if (swaps != -1) {
+    v = (swaps % 2) ? -1 : 1;
+    for (int i = 0; i < n; i++) {
+      if (ABS(a[i * n + i]) <= toler) {
+        v = 0;
+        break;
       }
+      v *= a[i * n + i];
+    }
+    if (integers) {
+      v = round(v);
     }
   }
+
+  free(p);
+  return v;
 }
 
 /*
- * Determinant of A
+ * the sum of the elements, and the sum of their squares when sumsq is
+ * given. the four partial sums are independent so the compiler can keep
+ * them in vector registers
  */
-var_num_t mat_determ(var_num_t *a, int n, double toler) {
-  int *done;
+static var_num_t stat_sum(const var_num_t *e, int count, var_num_t *sumsq) {
+  var_num_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  var_num_t q0 = 0, q1 = 0, q2 = 0, q3 = 0;
   int i;
-  var_num_t v;
 
-  done = malloc(n * sizeof(int));
-  for (i = 0; i < n; i++) {
-    done[i] = 0;
+  for (i = 0; i + 4 <= count; i += 4) {
+    s0 += e[i];
+    s1 += e[i + 1];
+    s2 += e[i + 2];
+    s3 += e[i + 3];
+    q0 += e[i] * e[i];
+    q1 += e[i + 1] * e[i + 1];
+    q2 += e[i + 2] * e[i + 2];
+    q3 += e[i + 3] * e[i + 3];
   }
-  v = 0;
-  mat_det2(1, 0, 0, a, done, &v, n, toler);
+  for (; i < count; i++) {
+    s0 += e[i];
+    q0 += e[i] * e[i];
+  }
+  if (sumsq) {
+    *sumsq = (q0 + q1) + (q2 + q3);
+  }
+  return (s0 + s1) + (s2 + s3);
+}
 
-  free(done);
-  return v;
+/*
+ * the sum of the distances of the elements from the mean, squared when
+ * square is set
+ */
+static var_num_t stat_dev(const var_num_t *e, int count, var_num_t mean, int square) {
+  var_num_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  int i = 0;
+
+  if (square) {
+    for (; i + 4 <= count; i += 4) {
+      var_num_t d0 = e[i] - mean;
+      var_num_t d1 = e[i + 1] - mean;
+      var_num_t d2 = e[i + 2] - mean;
+      var_num_t d3 = e[i + 3] - mean;
+      s0 += d0 * d0;
+      s1 += d1 * d1;
+      s2 += d2 * d2;
+      s3 += d3 * d3;
+    }
+    for (; i < count; i++) {
+      s0 += (e[i] - mean) * (e[i] - mean);
+    }
+  } else {
+    for (; i + 4 <= count; i += 4) {
+      s0 += fabs(e[i] - mean);
+      s1 += fabs(e[i + 1] - mean);
+      s2 += fabs(e[i + 2] - mean);
+      s3 += fabs(e[i + 3] - mean);
+    }
+    for (; i < count; i++) {
+      s0 += fabs(e[i] - mean);
+    }
+  }
+  return (s0 + s1) + (s2 + s3);
 }
 
 /*
  */
 var_num_t statmeandev(var_num_t *e, int count) {
-  var_num_t sum = 0.0;
-  var_num_t mean;
-  int i;
-
   if (count == 0) {
     return 0;
   }
 
-  for (i = 0; i < count; i++) {
-    sum += e[i];
-  }
-  mean = sum / count;
-
-  sum = 0.0;
-  for (i = 0; i < count; i++) {
-    sum += fabsl(e[i] - mean);
-  }
-
-  return sum / count;
+  var_num_t mean = stat_sum(e, count, NULL) / count;
+  return stat_dev(e, count, mean, 0) / count;
 }
 
 //
@@ -241,85 +293,190 @@ int median_compare(const void * a, const void * b) {
   return (fa > fb) - (fa < fb);
 }
 
+static int rank_compare(const void *a, const void *b) {
+  return *(const int *)a - *(const int *)b;
+}
+
 //
-// Median
+// Moves the k-th smallest of e[lo..hi] into e[k], with the smaller
+// elements before it and the larger ones after. This is quickselect with
+// a median of three pivot, taking O(n) on average. When the partitions
+// keep coming out uneven the range is sorted instead, so the worst case
+// stays at O(n log n)
+//
+static void stat_select(var_num_t *e, int lo, int hi, int k) {
+  int depth = 2;
+  for (int n = hi - lo + 1; n > 1; n >>= 1) {
+    depth += 2;
+  }
+
+  while (hi > lo) {
+    if (--depth == 0) {
+      qsort(e + lo, hi - lo + 1, sizeof(var_num_t), median_compare);
+      return;
+    }
+
+    // order e[lo], e[mid], e[hi] and take the middle one as the pivot
+    int mid = lo + (hi - lo) / 2;
+    var_num_t swp;
+    if (e[mid] < e[lo]) {
+      SWAP(e[mid], e[lo], swp);
+    }
+    if (e[hi] < e[lo]) {
+      SWAP(e[hi], e[lo], swp);
+    }
+    if (e[hi] < e[mid]) {
+      SWAP(e[hi], e[mid], swp);
+    }
+    var_num_t pivot = e[mid];
+
+    int i = lo;
+    int j = hi;
+    while (i <= j) {
+      while (e[i] < pivot) {
+        i++;
+      }
+      while (e[j] > pivot) {
+        j--;
+      }
+      if (i <= j) {
+        SWAP(e[i], e[j], swp);
+        i++;
+        j--;
+      }
+    }
+
+    // e[lo..j] <= pivot, e[i..hi] >= pivot and anything between equals pivot
+    if (k <= j) {
+      hi = j;
+    } else if (k >= i) {
+      lo = i;
+    } else {
+      break;
+    }
+  }
+}
+
+//
+// Selects each of the sorted ranks, the ranks either side of the middle
+// one are then found within the two partitions it leaves
+//
+static void stat_multiselect(var_num_t *e, int lo, int hi, const int *ranks, int count) {
+  if (count > 0 && lo < hi) {
+    int m = count / 2;
+    int k = ranks[m];
+    stat_select(e, lo, hi, k);
+    stat_multiselect(e, lo, k - 1, ranks, m);
+    stat_multiselect(e, k + 1, hi, ranks + m + 1, count - m - 1);
+  }
+}
+
 //
-// Median is calculated using quicksort with a complexity of O(n log n).
-// Faster approch would be to implement i.e. quickselect with a 
-// complexity of O(n).
+// Median
 //
-var_num_t statmedian(var_num_t *e, int count) {  
+var_num_t statmedian(var_num_t *e, int count) {
   if (count == 0) {
     return 0;
   }
 
-  qsort(e, count, sizeof(var_num_t), median_compare);
+  int k = count / 2;
+  stat_select(e, 0, count - 1, k);
 
   if (count % 2 == 0) {
-    return (e[count/2] + e[count/2 - 1]) / 2;
-  } else {  
-    return e[count/2];
-  }  
+    // the other middle element is the largest of the lower half
+    var_num_t below = e[0];
+    for (int i = 1; i < k; i++) {
+      if (e[i] > below) {
+        below = e[i];
+      }
+    }
+    return (e[k] + below) / 2;
+  } else {
+    return e[k];
+  }
 }
 
 //
-// Standard deviation
+// Quantiles, h = (count - 1) * p with linear interpolation between the
+// elements of rank floor(h) and floor(h) + 1. All the ranks are selected
+// together, so the array is only partitioned once for each distinct rank
 //
-var_num_t statstd(var_num_t *e, int count) {
-  var_num_t sum = 0.0;
-  var_num_t mean;
-  int i;
-
+void statquantile(var_num_t *e, int count, const var_num_t *p, var_num_t *result, int n) {
   if (count == 0) {
-    return 0;
+    for (int i = 0; i < n; i++) {
+      result[i] = 0;
+    }
+    return;
+  }
+
+  int *ranks = (int *)malloc(sizeof(int) * n * 2);
+  int nranks = 0;
+  for (int i = 0; i < n; i++) {
+    var_num_t h = (count - 1) * p[i];
+    int lo = (int)h;
+    ranks[nranks++] = lo;
+    if (lo + 1 < count && h > lo) {
+      ranks[nranks++] = lo + 1;
+    }
   }
+  qsort(ranks, nranks, sizeof(int), rank_compare);
 
-  for (i = 0; i < count; i++) {
-    sum += e[i];
+  // remove the duplicates
+  int unique = 0;
+  for (int i = 0; i < nranks; i++) {
+    if (unique == 0 || ranks[unique - 1] != ranks[i]) {
+      ranks[unique++] = ranks[i];
+    }
   }
-  mean = sum / count;
+  stat_multiselect(e, 0, count - 1, ranks, unique);
+  free(ranks);
+
+  for (int i = 0; i < n; i++) {
+    var_num_t h = (count - 1) * p[i];
+    int lo = (int)h;
+    if (lo + 1 < count && h > lo) {
+      result[i] = e[lo] + (h - lo) * (e[lo + 1] - e[lo]);
+    } else {
+      result[i] = e[lo];
+    }
+  }
+}
 
-  sum = 0.0;
-  for (i = 0; i < count; i++) {
-    sum += pow(fabsl(e[i] - mean),2);
+//
+// Standard deviation
+//
+var_num_t statstd(var_num_t *e, int count) {
+  if (count == 0) {
+    return 0;
   }
 
-  return sqrt(sum / (count - 1));
+  var_num_t mean = stat_sum(e, count, NULL) / count;
+  return sqrt(stat_dev(e, count, mean, 1) / (count - 1));
 }
 
 /*
  */
 var_num_t statspreads(var_num_t *e, int count) {
-  var_num_t sumsq = 0.0, sum = 0.0;
-  int i;
+  var_num_t sumsq, sum;
 
   if (count <= 1) {
     return 0;
   }
 
-  for (i = 0; i < count; i++) {
-    sum += e[i];
-    sumsq += (e[i] * e[i]);
-  }
-
+  sum = stat_sum(e, count, &sumsq);
   return sumsq / (count - 1) - (sum * sum) / (count * (count - 1));
 }
 
 /*
  */
 var_num_t statspreadp(var_num_t *e, int count) {
-  var_num_t sumsq = 0.0, sum = 0.0;
-  int i;
+  var_num_t sumsq, sum;
 
   if (count <= 0) {
     return 0;
   }
 
-  for (i = 0; i < count; i++) {
-    sum += e[i];
-    sumsq += (e[i] * e[i]);
-  }
-
+  sum = stat_sum(e, count, &sumsq);
   return sumsq / count - (sum * sum) / (count * count);
 }
 
@@ -438,27 +595,21 @@ var_num_t statspreadp(var_num_t *e, int count) {
 //
 // ROOT low, high, maxseg, maxerr, BYREF result, BYREF errcode USE ...
 //
-void root_iterate(var_num_t xl, var_num_t xh, var_num_t fl, var_num_t fh, var_t *res_vp, var_num_t maxerr,
-    var_t *err_vp, bcip_t use_ip) {
+static void root_iterate(var_num_t xl, var_num_t xh, var_num_t fl, var_num_t fh, var_num_t *res, var_num_t maxerr,
+    var_int_t *err, usefunc_t *uf) {
   var_num_t t, x;
-  var_t var;
 
-  v_init(&var);
   do {
     x = (xl + xh) / 2.0;
 
-    var.type = V_NUM;
-    var.v.n = x;
-    exec_usefunc(&var, use_ip);
+    t = exec_usefunc_num(uf, x, 0);
     if (prog_error) {
       return;
     }
-    t = v_getval(&var);
-    v_free(&var);
 
     if (ABS(t) < maxerr) {
-      res_vp->v.n = x;
-      err_vp->v.i = 0;
+      *res = x;
+      *err = 0;
       return;
     } else {
       if (t * fl > 0.0) {
@@ -467,20 +618,68 @@ void root_iterate(var_num_t xl, var_num_t xh, var_num_t fl, var_num_t fh, var_t
         (xh = x, fh = t);
       }
     }
-  } while (err_vp->v.i);
+  } while (*err);
+}
+
+static void root_search(var_num_t xl, var_num_t xh, int maxseg, var_num_t maxerr, var_num_t *res,
+    var_int_t *err, usefunc_t *uf) {
+  int j, nseg;
+  var_num_t fl, fh, x, width;
+
+  fl = exec_usefunc_num(uf, xl, 0);
+  if (prog_error)
+    return;
+
+  fh = exec_usefunc_num(uf, xh, 0);
+  if (prog_error)
+    return;
+
+  if (ABS(fl) < maxerr) {
+    *err = 0;
+    *res = xl;
+    return;
+  }
+
+  if (ABS(fh) < maxerr) {
+    *err = 0;
+    *res = xh;
+    return;
+  }
+
+  if (fl * fh < 0) {
+    root_iterate(xl, xh, fl, fh, res, maxerr, err, uf);
+    return;
+  }
+
+  nseg = 2;
+  do {
+    width = (xh - xl) / nseg;
+    for (j = 1; j <= (nseg >> 1); j++) {
+      x = xl + width * (2 * j - 1);
+
+      fh = exec_usefunc_num(uf, x, 0);
+      if (prog_error)
+        return;
+
+      if (fh * fl < 0) {
+        xh = x;
+        root_iterate(xl, xh, fl, fh, res, maxerr, err, uf);
+        return;
+      }
+    }
+    nseg = nseg << 1;
+  } while (nseg <= maxseg);
 }
 
 void cmd_root() {
   var_t *res_vp, *err_vp;
   var_num_t low, high, maxerr;
-  int maxseg, nseg;
+  int maxseg;
   bcip_t use_ip, exit_ip = INVALID_ADDR;
-  var_t var;
+  usefunc_t uf;
+  var_num_t res = 0;
+  var_int_t err = 1;
 
-  int j;
-  var_num_t xl, xh, fl, fh, x, width;
-
-  v_init(&var);
   low = par_getnum();
   if (prog_error)
     return;
@@ -525,77 +724,14 @@ void cmd_root() {
   use_ip = code_getaddr();
   exit_ip = code_getaddr();
 
-  //
-  v_free(res_vp);
-  v_free(err_vp);
-  res_vp->type = V_NUM;
-  res_vp->v.n = 0;
-  err_vp->type = V_INT;
-  err_vp->v.i = 1;
-
-  xl = low;
-  xh = high;
-
-  var.type = V_NUM;
-  var.v.n = xl;
-  exec_usefunc(&var, use_ip);
-  if (prog_error)
-    return;
-  fl = v_getval(&var);
-  v_free(&var);
-
-  var.type = V_NUM;
-  var.v.n = xh;
-  exec_usefunc(&var, use_ip);
+  exec_usefunc_begin(&uf, use_ip, 1);
+  root_search(low, high, maxseg, maxerr, &res, &err, &uf);
+  exec_usefunc_end(&uf);
   if (prog_error)
     return;
-  fh = v_getval(&var);
-  v_free(&var);
-
-  if (ABS(fl) < maxerr) {
-    err_vp->v.i = 0;
-    res_vp->v.n = xl;
-    code_jump(exit_ip);
-    return;
-  }
-
-  if (ABS(fh) < maxerr) {
-    err_vp->v.i = 0;
-    res_vp->v.n = xh;
-    code_jump(exit_ip);
-    return;
-  }
-
-  if (fl * fh < 0) {
-    root_iterate(xl, xh, fl, fh, res_vp, maxerr, err_vp, use_ip);
-    code_jump(exit_ip);
-    return;
-  }
-
-  nseg = 2;
-  do {
-    width = (xh - xl) / nseg;
-    for (j = 1; j <= (nseg >> 1); j++) {
-      x = xl + width * (2 * j - 1);
-
-      var.type = V_NUM;
-      var.v.n = x;
-      exec_usefunc(&var, use_ip);
-      if (prog_error)
-        return;
-      fh = v_getval(&var);
-      v_free(&var);
-
-      if (fh * fl < 0) {
-        xh = x;
-        root_iterate(xl, xh, fl, fh, res_vp, maxerr, err_vp, use_ip);
-        code_jump(exit_ip);
-        return;
-      }
-    }
-    nseg = nseg << 1;
-  } while (nseg <= maxseg);
 
+  v_setreal(res_vp, res);
+  v_setint(err_vp, err);
   code_jump(exit_ip);
 }
 
@@ -607,11 +743,12 @@ void cmd_deriv() {
   double maxerr, x;
   int maxseg, nseg;
   bcip_t use_ip, exit_ip = INVALID_ADDR;
-  var_t var;
+  usefunc_t uf;
 
   double delta = 0.01, f1, f2, f3, fp, op = 0.0, errval;
+  double res = 0;
+  var_int_t err = 1;
 
-  v_init(&var);
   x = par_getnum();
   if (prog_error)
     return;
@@ -650,39 +787,20 @@ void cmd_deriv() {
   use_ip = code_getaddr();
   exit_ip = code_getaddr();
 
-  //
-  v_free(res_vp);
-  v_free(err_vp);
-  res_vp->type = V_NUM;
-  res_vp->v.n = 0;
-  err_vp->type = V_INT;
-  err_vp->v.i = 1;
-
+  exec_usefunc_begin(&uf, use_ip, 1);
   nseg = 0;
   do {
-    var.type = V_NUM;
-    var.v.n = x;
-    exec_usefunc(&var, use_ip);
+    f1 = exec_usefunc_num(&uf, x, 0);
     if (prog_error)
-      return;
-    f1 = v_getval(&var);
-    v_free(&var);
+      break;
 
-    var.type = V_NUM;
-    var.v.n = x + delta;
-    exec_usefunc(&var, use_ip);
+    f2 = exec_usefunc_num(&uf, x + delta, 0);
     if (prog_error)
-      return;
-    f2 = v_getval(&var);
-    v_free(&var);
+      break;
 
-    var.type = V_NUM;
-    var.v.n = x + 2 * delta;
-    exec_usefunc(&var, use_ip);
+    f3 = exec_usefunc_num(&uf, x + 2 * delta, 0);
     if (prog_error)
-      return;
-    f3 = v_getval(&var);
-    v_free(&var);
+      break;
 
     fp = (-3.0 * f1 + 4.0 * f2 - f3) / 2.0 / delta;
     if (fp == 0.0)
@@ -692,20 +810,25 @@ void cmd_deriv() {
 
     nseg++;
     if (nseg >= maxseg) {
-      res_vp->v.n = fp;
+      res = fp;
       break;
     }
 
     if (errval < maxerr) {
-      res_vp->v.n = fp;
-      err_vp->v.i = 0;
+      res = fp;
+      err = 0;
     }
 
     delta = delta / 2.0;
     op = fp;
 
-  } while (err_vp->v.i);
+  } while (err);
+  exec_usefunc_end(&uf);
+  if (prog_error)
+    return;
 
+  v_setreal(res_vp, res);
+  v_setint(err_vp, err);
   code_jump(exit_ip);
 }
 
@@ -717,13 +840,12 @@ void cmd_diffeq() {
   double maxerr;
   int maxseg, nseg, j;
   bcip_t use_ip, exit_ip = INVALID_ADDR;
-  var_t var, var2;
+  usefunc_t uf;
 
   double x0, x1, y0, width, hw, ka, kb, kc, kd, xi, yi;
-  double errval, yp = 0;
+  double errval, yp = 0, res = 0;
+  var_int_t err = 1;
 
-  v_init(&var);
-  v_init(&var2);
   x0 = par_getnum();
   if (prog_error)
     return;
@@ -774,90 +896,55 @@ void cmd_diffeq() {
   use_ip = code_getaddr();
   exit_ip = code_getaddr();
 
-  //
-  v_free(res_vp);
-  v_free(err_vp);
-  res_vp->type = V_NUM;
-  res_vp->v.n = 0;
-  err_vp->type = V_INT;
-  err_vp->v.i = 1;
-
+  exec_usefunc_begin(&uf, use_ip, 2);
   nseg = 1;
   do {
     width = (x1 - x0) / nseg;
     hw = width / 2.0;
 
-    for (j = 1; j <= nseg; j++) {
+    for (j = 1; j <= nseg && !prog_error; j++) {
       xi = x0 + (j - 1) * width;
       //                      xf = xi + width;
       if (j == 1)
         yi = y0;
       else
-        yi = res_vp->v.n;
+        yi = res;
 
-      var.type = V_NUM;
-      var.v.n = xi;
-      var2.type = V_NUM;
-      var2.v.n = yi;
-      exec_usefunc2(&var, &var2, use_ip);
-      if (prog_error)
-        return;
-      ka = v_getval(&var);
-      v_free(&var);
-
-      var.type = V_NUM;
-      var.v.n = xi + hw;
-      var2.type = V_NUM;
-      var2.v.n = yi + ka * hw;
-      exec_usefunc2(&var, &var2, use_ip);
-      if (prog_error)
-        return;
-      kb = v_getval(&var);
-      v_free(&var);
-
-      var.type = V_NUM;
-      var.v.n = xi + hw;
-      var2.type = V_NUM;
-      var2.v.n = yi + kb * hw;
-      exec_usefunc2(&var, &var2, use_ip);
-      if (prog_error)
-        return;
-      kc = v_getval(&var);
-      v_free(&var);
-
-      var.type = V_NUM;
-      var.v.n = xi + width;
-      var2.type = V_NUM;
-      var2.v.n = yi + kc * width;
-      exec_usefunc2(&var, &var2, use_ip);
-      if (prog_error)
-        return;
-      kd = v_getval(&var);
-      v_free(&var);
+      ka = exec_usefunc_num(&uf, xi, yi);
+      kb = exec_usefunc_num(&uf, xi + hw, yi + ka * hw);
+      kc = exec_usefunc_num(&uf, xi + hw, yi + kb * hw);
+      kd = exec_usefunc_num(&uf, xi + width, yi + kc * width);
 
-      res_vp->v.n = yi + width * (ka + 2.0 * kb + 2.0 * kc + kd) / 6.0;
+      res = yi + width * (ka + 2.0 * kb + 2.0 * kc + kd) / 6.0;
     }
+    if (prog_error)
+      break;
 
     if (nseg == 1)
       errval = maxerr;
     else {
-      if (res_vp->v.n == 0)
+      if (res == 0)
         errval = 0;
       else
-        errval = ABS((res_vp->v.n - yp) / res_vp->v.n);
+        errval = ABS((res - yp) / res);
     }
 
     if (nseg > maxseg)
       break;
 
     if (errval < maxerr || width == 0) {
-      err_vp->v.i = 0;
+      err = 0;
       break;
     }
 
-    yp = res_vp->v.n;
+    yp = res;
     nseg = nseg << 1;
-  } while (err_vp->v.i);
+  } while (err);
+  exec_usefunc_end(&uf);
+  if (prog_error)
+    return;
 
+  v_setreal(res_vp, res);
+  v_setint(err_vp, err);
   code_jump(exit_ip);
 }
@@ -49,8 +49,29 @@ void mat_gauss_jordan(var_num_t *a, var_num_t *b, int n, double toler);
  */
 void mat_inverse(var_num_t *a, int n);
 
-void mat_det2(var_num_t t, int m, int k, var_num_t *a, int *done, var_num_t *v, int n, double toler)
-   ;
+/**
+ * @ingroup math
+ *
+ * in-place LU decomposition with partial pivoting. the rows of a are
+ * interchanged, row i of the result holds the original row p[i]
+ *
+ * @param a is the matrix
+ * @param p receives the permutation of the rows
+ * @param n is the number of rows/cols
+ * @return the number of row exchanges, or -1 when the matrix is singular
+ */
+int mat_lu(var_num_t *a, int *p, int n);
+
+/**
+ * @ingroup math
+ *
+ * matrix product c = a * b
+ *
+ * @param a is the m x k matrix
+ * @param b is the k x n matrix
+ * @param c receives the m x n result
+ */
+void mat_product(const var_num_t *a, const var_num_t *b, var_num_t *c, int m, int n, int k);
 
 /**
  * @ingroup math
@@ -86,6 +107,19 @@ var_num_t statmeandev(var_num_t *e, int count);
  */
 var_num_t statmedian(var_num_t *e, int count);
 
+/**
+ * @ingroup math
+ *
+ * Quantiles, interpolated between the closest ranks. e is reordered
+ *
+ * @param e array with numbers
+ * @param count number of elements of e
+ * @param p the probabilities, each between 0 and 1
+ * @param result receives the quantile for each of p
+ * @param n number of elements of p
+ */
+void statquantile(var_num_t *e, int count, const var_num_t *p, var_num_t *result, int n);
+
 /**
  * @ingroup math
  * 
@@ -34,10 +34,19 @@ static char fileName[OS_FILENAME_SIZE + 1];
 static stknode_t err_node;
 
 #define EVT_CHECK_EVERY 50
+#define EVT_BUDGET_MAX  64
 #define IF_ERR_BREAK if (prog_error) { \
   if (prog_error == errThrow)       \
       prog_error = errNone; else break;}
 
+// event checker state, shared by nested bc_loop() calls. the clock is only
+// sampled once every evt_budget commands, with the budget sized from the
+// recent command rate to land the next sample on the next check time
+static uint32_t evt_next_check = 0;
+static uint32_t evt_last_sample = 0;
+static uint32_t evt_budget = 1;
+static uint32_t evt_countdown = 1;
+
 /**
  * jump to label
  */
@@ -103,6 +112,11 @@ void free_node(stknode_t *node) {
         v_free(node->x.vfor.arr_ptr);
         v_detach(node->x.vfor.arr_ptr);
       }
+    } else if (node->x.vfor.subtype == kwFILE) {
+      if (node->x.vfor.flags & 1) {
+        // opened in for
+        dev_fclose(node->x.vfor.step_expr_ip);
+      }
     }
     break;
 
@@ -558,6 +572,12 @@ static inline void bc_loop_call_proc() {
   case kwSEARCH:
     cmd_search();
     break;
+  case kwBSEARCH:
+    cmd_bsearch();
+    break;
+  case kwCSVSPLIT:
+    cmd_csvsplit();
+    break;
   case kwROOT:
     cmd_root();
     break;
@@ -711,6 +731,48 @@ void bc_loop_goto() {
   prog_ip = next_ip;
 }
 
+/**
+ * check events every ~50ms
+ */
+static void bc_loop_events() {
+  uint32_t now = dev_get_millisecond_count();
+  uint32_t elapsed = now - evt_last_sample;
+  evt_last_sample = now;
+
+  if (now >= evt_next_check) {
+    evt_next_check = now + EVT_CHECK_EVERY;
+
+    switch (dev_events(0)) {
+    case -1:
+      // break event
+      break;
+    case -2:
+      prog_error = errBreak;
+      inf_break(prog_line);
+      break;
+    default:
+      if (prog_timer) {
+        timer_run(now);
+      }
+    };
+  }
+
+  // number of commands expected to run until the next check time
+  uint64_t budget;
+  if (elapsed == 0) {
+    budget = evt_budget * 2;
+  } else {
+    budget = ((uint64_t)evt_budget * (evt_next_check - now)) / elapsed;
+  }
+  if (budget < 1) {
+    budget = 1;
+  } else if (budget > EVT_BUDGET_MAX) {
+    budget = EVT_BUDGET_MAX;
+  }
+  evt_budget = budget;
+  evt_countdown = budget;
+}
+
 /**
  * execute commands (loop)
  *
@@ -724,10 +786,6 @@ void bc_loop(int isf) {
   int proc_level = 0;
   byte code = 0;
 
-  // setup event checker time = 50ms
-  uint32_t now = dev_get_millisecond_count();
-  uint32_t next_check = now + EVT_CHECK_EVERY;
-
   /**
    * For commands that change the IP use
    *
@@ -747,29 +805,12 @@ void bc_loop(int isf) {
     case kwTYPE_LINE:
       break;
     default:
-      now = dev_get_millisecond_count();
+      if (--evt_countdown == 0) {
+        bc_loop_events();
+      }
       break;
     }
 
-    // check events every ~50ms
-    if (now >= next_check) {
-      next_check = now + EVT_CHECK_EVERY;
-
-      switch (dev_events(0)) {
-      case -1:
-        // break event
-        break;
-      case -2:
-        prog_error = errBreak;
-        inf_break(prog_line);
-        break;
-      default:
-        if (prog_timer) {
-          timer_run(now);
-        }
-      };
-    }
-
     // proceed to the next command
     if (!prog_error) {
       code = prog_source[prog_ip++];
@@ -790,6 +831,9 @@ void bc_loop(int isf) {
       case kwLET_OPT:
         cmd_let_opt();
         break;
+      case kwLET_APPEND:
+        cmd_let_append();
+        break;
       case kwCONST:
         cmd_let(1);
         break;
@@ -991,6 +1035,9 @@ void bc_loop(int isf) {
       case kwSEEK:
         cmd_fseek();
         break;
+      case kwFLUSH:
+        cmd_fflush();
+        break;
       case kwTRON:
         opt_trace_on = 1;
         continue;
@@ -1206,7 +1253,7 @@ int brun_create_task(const char *filename, byte *preloaded_bc, int libf) {
       lseek(h, sizeof(unit_sym_t) * uft.sym_count, SEEK_CUR);
     }
     read(h, &hdr, sizeof(bc_head_t));
-    if (hdr.sbver != SB_DWORD_VER) {
+    if (hdr.sbver != SB_DWORD_VER || hdr.ver != SB_BC_VER) {
       panic("File '%s' version incorrect", fname);
     }
     source = malloc(hdr.size + 4);
@@ -1386,9 +1433,9 @@ int exec_close_task() {
 }
 
 /**
- * close the executor
+ * close the task and its child tasks
  */
-int exec_close(int tid) {
+static void exec_close_tree(int tid) {
   int prev_tid, i;
 
   prev_tid = activate_task(tid);
@@ -1397,7 +1444,7 @@ int exec_close(int tid) {
     activate_task(i);
 
     if (ctask->status == tsk_ready && ctask->parent == tid) {
-      exec_close(ctask->tid);
+      exec_close_tree(ctask->tid);
     }
   }
 
@@ -1405,6 +1452,16 @@ int exec_close(int tid) {
   exec_close_task();
   close_task(tid);
   activate_task(prev_tid);
+}
+
+/**
+ * close the executor
+ */
+int exec_close(int tid) {
+  exec_close_tree(tid);
+
+  // return memory held by the var pool
+  v_close_pool();
   return 1;
 }
 
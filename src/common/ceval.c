@@ -23,6 +23,11 @@ static bc_t *bc_out;
 
 void cev_log(void);
 
+// operators which bind tighter than the right side operand
+static const code_t mul_binding[] = { kwTYPE_POWOPR, 0 };
+static const code_t add_binding[] = { kwTYPE_MULOPR, kwTYPE_POWOPR, 0 };
+static const code_t cmp_binding[] = { kwTYPE_ADDOPR, kwTYPE_MULOPR, kwTYPE_POWOPR, 0 };
+
 void cev_udp(void) {
   sc_raise("(EXPR): UDP INSIDE EXPR");
 }
@@ -47,8 +52,10 @@ void cev_prim_str() {
 void cev_prim_uds() {
   while (CODE_PEEK() == kwTYPE_UDS_EL) {
     cev_add1(kwTYPE_UDS_EL);
+    bc_add_n(bc_out, bc_in->ptr + bc_in->cp + 1, OS_HASHSZ);
+    IP += OS_HASHSZ + 1;
     cev_add1(kwTYPE_STR);
-    IP += 2;
+    IP++;
     cev_prim_str();
   }
 }
@@ -156,6 +163,252 @@ void cev_check_dup_prim() {
   }
 }
 
+/*
+ * returns whether the next operand is a numeric constant or a plain
+ * variable which is not followed by an operator from the given set
+ */
+int cev_is_simple_prim(const code_t *binding) {
+  bcip_t next;
+  switch (CODE_PEEK()) {
+  case kwTYPE_INT:
+    next = IP + 1 + OS_INTSZ;
+    break;
+  case kwTYPE_NUM:
+    next = IP + 1 + OS_REALSZ;
+    break;
+  case kwTYPE_VAR:
+    next = IP + 1 + ADDRSZ;
+    if (CODE(next) == kwTYPE_LEVEL_BEGIN || CODE(next) == kwTYPE_UDS_EL) {
+      return 0;
+    }
+    break;
+  default:
+    return 0;
+  }
+  for (int i = 0; binding[i]; i++) {
+    if (CODE(next) == binding[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * reads the numeric constant operand at the given output position, returns
+ * the length of the operand or 0 when the operand is not a constant
+ */
+int cev_const_operand(bcip_t ip, var_t *v) {
+  int len;
+
+  if (ip >= bc_out->count) {
+    return 0;
+  }
+  switch (bc_out->ptr[ip]) {
+  case kwTYPE_INT:
+    v->type = V_INT;
+    memcpy(&v->v.i, bc_out->ptr + ip + 1, OS_INTSZ);
+    return 1 + OS_INTSZ;
+  case kwTYPE_NUM:
+    v->type = V_NUM;
+    memcpy(&v->v.n, bc_out->ptr + ip + 1, OS_REALSZ);
+    return 1 + OS_REALSZ;
+  case kwTYPE_LEVEL_BEGIN:
+    // (constant)
+    len = cev_const_operand(ip + 1, v);
+    if (len && ip + 1 + len < bc_out->count &&
+        bc_out->ptr[ip + 1 + len] == kwTYPE_LEVEL_END) {
+      return len + 2;
+    }
+    break;
+  default:
+    break;
+  }
+  return 0;
+}
+
+/*
+ * calculates LEFT op R when the result is the same as at runtime (see eval.c)
+ */
+int cev_fold_opr(var_t *r, var_t *left, code_t opr, code_t op) {
+  var_num_t lf = v_getval(left);
+  var_num_t rf = v_getval(r);
+  var_int_t li, ri;
+
+  switch (opr) {
+  case kwTYPE_ADDOPR:
+    if (op != '+' && op != '-') {
+      return 0;
+    }
+    if (r->type == V_INT && left->type == V_INT) {
+      r->v.i = (op == '+') ? left->v.i + r->v.i : left->v.i - r->v.i;
+    } else {
+      r->type = V_NUM;
+      r->v.n = (op == '+') ? lf + rf : lf - rf;
+    }
+    break;
+  case kwTYPE_MULOPR:
+    r->type = V_NUM;
+    switch (op) {
+    case '*':
+      r->v.n = lf * rf;
+      break;
+    case '/':
+      if (ABS(rf) == 0) {
+        // leave the error to the runtime
+        return 0;
+      }
+      r->v.n = lf / rf;
+      break;
+    case '\\':
+      li = lf;
+      ri = rf;
+      if (ri == 0) {
+        return 0;
+      }
+      r->type = V_INT;
+      r->v.i = li / ri;
+      break;
+    case '%':
+    case OPLOG_MOD:
+      if ((var_int_t) rf == 0) {
+        return 0;
+      }
+      ri = rf;
+      li = (lf < 0.0) ? -floor(-lf) : floor(lf);
+      r->type = V_INT;
+      r->v.i = li - ri * (li / ri);
+      break;
+    case OPLOG_MDL:
+      if (rf == 0) {
+        return 0;
+      }
+      r->v.n = fmod(lf, rf) + rf * (SGN(lf) != SGN(rf));
+      break;
+    default:
+      return 0;
+    }
+    break;
+  case kwTYPE_POWOPR:
+    r->type = V_NUM;
+    r->v.n = pow(lf, rf);
+    break;
+  case kwTYPE_CMPOPR:
+    switch (op) {
+    case OPLOG_EQ:
+      li = (v_compare(left, r) == 0);
+      break;
+    case OPLOG_GT:
+      li = (v_compare(left, r) > 0);
+      break;
+    case OPLOG_GE:
+      li = (v_compare(left, r) >= 0);
+      break;
+    case OPLOG_LT:
+      li = (v_compare(left, r) < 0);
+      break;
+    case OPLOG_LE:
+      li = (v_compare(left, r) <= 0);
+      break;
+    case OPLOG_NE:
+      li = (v_compare(left, r) != 0);
+      break;
+    default:
+      return 0;
+    }
+    r->type = V_INT;
+    r->v.i = li;
+    break;
+  default:
+    return 0;
+  }
+  return 1;
+}
+
+/*
+ * replaces the code from the given position with the constant value
+ */
+void cev_fold_emit(bcip_t ip, var_t *v) {
+  bc_out->count = ip;
+  if (v->type == V_INT) {
+    bc_add_cint(bc_out, v->v.i);
+  } else {
+    bc_add_creal(bc_out, v->v.n);
+  }
+}
+
+/*
+ * constant folding of the last binary operation, starting at ip
+ *
+ * [L] kwTYPE_EVPRIM [R] opr op
+ * [L] kwTYPE_EVPUSH [R] kwTYPE_EVPOP opr op
+ */
+void cev_fold(bcip_t ip) {
+  var_t left, r;
+
+  IF_ERR_RTN;
+  int len = cev_const_operand(ip, &left);
+  bcip_t next = ip + len;
+  if (!len || next >= bc_out->count) {
+    return;
+  }
+  byte code = bc_out->ptr[next++];
+  if (code != kwTYPE_EVPRIM && code != kwTYPE_EVPUSH) {
+    return;
+  }
+  len = cev_const_operand(next, &r);
+  next += len;
+  if (!len || next >= bc_out->count) {
+    return;
+  }
+  if (code == kwTYPE_EVPUSH) {
+    if (bc_out->ptr[next] != kwTYPE_EVPOP) {
+      return;
+    }
+    next++;
+  }
+  if (next + 2 == bc_out->count &&
+      cev_fold_opr(&r, &left, bc_out->ptr[next], bc_out->ptr[next + 1])) {
+    cev_fold_emit(ip, &r);
+  }
+}
+
+/*
+ * constant folding of the last unary operation, starting at ip
+ *
+ * [R] kwTYPE_UNROPR op
+ */
+void cev_fold_unary(bcip_t ip) {
+  var_t r;
+
+  IF_ERR_RTN;
+  int len = cev_const_operand(ip, &r);
+  if (!len || ip + len + 2 != bc_out->count) {
+    return;
+  }
+  switch (bc_out->ptr[ip + len + 1]) {
+  case '-':
+    if (r.type == V_INT) {
+      r.v.i = -r.v.i;
+    } else {
+      r.v.n = -r.v.n;
+    }
+    break;
+  case '+':
+    break;
+  case OPLOG_INV:
+    r.v.i = ~v_igetval(&r);
+    r.type = V_INT;
+    break;
+  case OPLOG_NOT:
+    r.v.i = !v_igetval(&r);
+    r.type = V_INT;
+    break;
+  default:
+    return;
+  }
+  cev_fold_emit(ip, &r);
+}
+
 /*
  * prim
  */
@@ -247,10 +500,12 @@ void cev_unary() {
   } else {
     op = 0;
   }
+  bcip_t start = bc_out->count;
   cev_parenth();        // R = cev_parenth
   if (op) {
     cev_add1(kwTYPE_UNROPR);
     cev_add1(op);       // R = op R
+    cev_fold_unary(start);
   }
 }
 
@@ -258,6 +513,7 @@ void cev_unary() {
  * pow
  */
 void cev_pow() {
+  bcip_t start = bc_out->count;
   cev_unary();                  // R = cev_unary
 
   IF_ERR_RTN;
@@ -269,6 +525,7 @@ void cev_pow() {
     IF_ERR_RTN;
     cev_add1(kwTYPE_EVPOP);     // POP LEFT
     cev_add2(kwTYPE_POWOPR, '^'); // R = LEFT op R
+    cev_fold(start);
   }
 }
 
@@ -276,6 +533,7 @@ void cev_pow() {
  * mul | div | mod
  */
 void cev_mul() {
+  bcip_t start = bc_out->count;
   cev_pow();                    // R = cev_pow()
 
   IF_ERR_RTN;
@@ -284,12 +542,17 @@ void cev_mul() {
 
     op = CODE(++IP);
     IP++;
-    cev_add1(kwTYPE_EVPUSH);    // PUSH R
-
-    cev_pow();
-    IF_ERR_RTN;
-    cev_add1(kwTYPE_EVPOP);      // POP LEFT
+    if (cev_is_simple_prim(mul_binding)) {
+      cev_add1(kwTYPE_EVPRIM);   // LEFT = R, R = prim
+      cev_prim();
+    } else {
+      cev_add1(kwTYPE_EVPUSH);   // PUSH R
+      cev_pow();
+      IF_ERR_RTN;
+      cev_add1(kwTYPE_EVPOP);    // POP LEFT
+    }
     cev_add2(kwTYPE_MULOPR, op); // R = LEFT op R
+    cev_fold(start);
   }
 }
 
@@ -297,6 +560,7 @@ void cev_mul() {
  * add | sub
  */
 void cev_add() {
+  bcip_t start = bc_out->count;
   cev_mul();                    // R = cev_mul()
 
   IF_ERR_RTN;
@@ -306,13 +570,17 @@ void cev_add() {
     IP++;
     op = CODE(IP);
     IP++;
-    cev_add1(kwTYPE_EVPUSH);    // PUSH R
-
-    cev_mul();                  // R = cev_mul
-    IF_ERR_RTN;
-
-    cev_add1(kwTYPE_EVPOP);    // POP LEFT
+    if (cev_is_simple_prim(add_binding)) {
+      cev_add1(kwTYPE_EVPRIM);  // LEFT = R, R = prim
+      cev_prim();
+    } else {
+      cev_add1(kwTYPE_EVPUSH);  // PUSH R
+      cev_mul();                // R = cev_mul
+      IF_ERR_RTN;
+      cev_add1(kwTYPE_EVPOP);   // POP LEFT
+    }
     cev_add2(kwTYPE_ADDOPR, op); // R = LEFT op R
+    cev_fold(start);
   }
 }
 
@@ -320,6 +588,7 @@ void cev_add() {
  * compare
  */
 void cev_cmp() {
+  bcip_t start = bc_out->count;
   cev_add();                    // R = cev_add()
 
   IF_ERR_RTN;
@@ -329,11 +598,17 @@ void cev_cmp() {
     IP++;
     op = CODE(IP);
     IP++;
-    cev_add1(kwTYPE_EVPUSH);    // PUSH R
-    cev_add();                  // R = cev_add()
-    IF_ERR_RTN;
-    cev_add1(kwTYPE_EVPOP);         // POP LEFT
+    if (cev_is_simple_prim(cmp_binding)) {
+      cev_add1(kwTYPE_EVPRIM);  // LEFT = R, R = prim
+      cev_prim();
+    } else {
+      cev_add1(kwTYPE_EVPUSH);  // PUSH R
+      cev_add();                // R = cev_add()
+      IF_ERR_RTN;
+      cev_add1(kwTYPE_EVPOP);   // POP LEFT
+    }
     cev_add2(kwTYPE_CMPOPR, op);    // R = LEFT op R
+    cev_fold(start);
   }
 }
 
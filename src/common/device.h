@@ -803,6 +803,11 @@ typedef struct {
   int handle;         /**< the file handle */
   int last_error;     /**< the last error-code */
   int open_flags;     /**< the open()'s flags */
+
+  byte *buffer;       /**< ft_stream read/write buffer, NULL when unbuffered */
+  uint32_t buf_pos;   /**< the next byte to read, or the number of bytes to write */
+  uint32_t buf_len;   /**< the number of bytes read into the buffer */
+  int buf_dirty;      /**< non-zero when the buffer holds bytes to write */
 } dev_file_t;
 
 // flags for dev_fopen()
@@ -870,6 +875,60 @@ uint32_t dev_flength(int SBHandle);
  */
 int dev_fclose(int SBHandle);
 
+/**
+ * @ingroup dev_f
+ *
+ * writes any buffered output to the file
+ *
+ * @param SBHandle is the RTL's file-handle
+ * @returns non-zero on success
+ */
+int dev_fflush(int SBHandle);
+
+/**
+ * @ingroup dev_f
+ *
+ * reads the next line into a string variable, without the line ending
+ *
+ * @param SBHandle is the RTL's file-handle
+ * @param var is the variable to store the line
+ * @returns non-zero when a line was read, zero at the end of the file
+ */
+int dev_freadln(int SBHandle, var_t *var);
+
+/**
+ * @ingroup dev_f
+ *
+ * opens a file on a handle which the user's commands can't see,
+ * for files that stay open while user code runs
+ *
+ * @param name is the filename
+ * @param flags are the flags for open-mode (see DEV_FILE_xxx macros)
+ * @returns the file-handle on success; otherwise 0
+ */
+int dev_fopen_hidden(const char *name, int flags);
+
+/**
+ * @ingroup dev_f
+ *
+ * reads the next line from a file opened with dev_fopen_hidden()
+ *
+ * @param SBHandle is the file-handle returned by dev_fopen_hidden()
+ * @param var is the variable to store the line
+ * @returns non-zero when a line was read, zero at the end of the file
+ */
+int dev_freadln_hidden(int SBHandle, var_t *var);
+
+/**
+ * @ingroup dev_f
+ *
+ * closes a file opened with dev_fopen_hidden()
+ *
+ * @param SBHandle is the file-handle returned by dev_fopen_hidden()
+ * @returns non-zero on success
+ */
+int dev_fclose_hidden(int SBHandle);
+
 /**
  * @ingroup dev_f
  *
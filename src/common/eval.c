@@ -15,6 +15,7 @@
 #include "common/device.h"
 #include "common/plugins.h"
 #include "common/var_eval.h"
+#include "common/blib_math.h"
 
 #define IP           prog_ip
 #define CODE(x)      prog_source[(x)]
@@ -33,21 +34,20 @@
   }
 
 //
-// matrix: convert var_t to double[r][c]
+// matrix: the number of rows and columns, a 1d array is a single row
 //
-var_num_t *mat_toc(var_t *v, int32_t *rows, int32_t *cols) {
-  var_num_t *m = NULL;
+static int mat_dims(var_t *v, int32_t *rows, int32_t *cols) {
   *rows = *cols = 0;
 
   if (!v) {
     // uninitialised variable
-    return NULL;
+    return 0;
   }
 
   if (v_maxdim(v) > 2) {
     // too many dimensions
     err_matdim();
-    return NULL;
+    return 0;
   }
   *rows = ABS(v_lbound(v, 0) - v_ubound(v, 0)) + 1;
 
@@ -57,14 +57,21 @@ var_num_t *mat_toc(var_t *v, int32_t *rows, int32_t *cols) {
     *cols = *rows;
     *rows = 1;
   }
+  return 1;
+}
 
-  m = (var_num_t *)malloc(((*rows) * (*cols)) * sizeof(var_num_t));
-  for (int i = 0; i < *rows; i++) {
-    for (int j = 0; j < *cols; j++) {
-      int pos = i * (*cols) + j;
-      var_t *e = v_elem(v, pos);
-      m[pos] = v_getval(e);
-    }
+//
+// matrix: convert var_t to double[r][c]
+//
+var_num_t *mat_toc(var_t *v, int32_t *rows, int32_t *cols) {
+  if (!mat_dims(v, rows, cols)) {
+    return NULL;
+  }
+
+  int32_t size = (*rows) * (*cols);
+  var_num_t *m = (var_num_t *)malloc(size * sizeof(var_num_t));
+  for (int pos = 0; pos < size; pos++) {
+    m[pos] = v_getval(v_elem(v, pos));
   }
 
   return m;
@@ -90,37 +97,70 @@ void mat_tov(var_t *v, var_num_t *m, int32_t rows, int32_t cols, int protect_col
 }
 
 //
-// matrix: 1op
+// matrix: gives the result the same shape as mat_tov, without moving the elements
+//
+static void mat_reshape(var_t *v, int32_t rows, int32_t cols, int dims) {
+  v_maxdim(v) = dims;
+  v_lbound(v, 0) = opt_base;
+  if (dims == 1) {
+    v_ubound(v, 0) = opt_base + (rows * cols - 1);
+  } else {
+    v_ubound(v, 0) = opt_base + (rows - 1);
+    v_lbound(v, 1) = opt_base;
+    v_ubound(v, 1) = opt_base + (cols - 1);
+  }
+}
+
+//
+// matrix: stores the number, replacing any string value
+//
+static inline void mat_setval(var_t *e, var_num_t n) {
+  if (e->type != V_NUM && e->type != V_INT) {
+    v_free(e);
+  }
+  e->type = V_NUM;
+  e->v.n = n;
+}
+
+//
+// matrix: 1op, applied in place to each element
 //
 void mat_op1(var_t *l, int op, var_num_t n) {
   int32_t lr, lc;
 
-  var_num_t *m1 = mat_toc(l, &lr, &lc);
-  if (m1) {
-    var_num_t *m = (var_num_t *)malloc(sizeof(var_num_t) * lr * lc);
-    for (int i = 0; i < lr; i++) {
-      for (int j = 0; j < lc; j++) {
-        int pos = i * lc + j;
-        switch (op) {
-        case '*':
-          m[pos] = m1[pos] * n;
-          break;
-        case 'A':
-          m[pos] = -m1[pos];
-          break;
-        default:
-          m[pos] = 0;
-          break;
-        }
+  if (mat_dims(l, &lr, &lc)) {
+    uint32_t size = v_asize(l);
+    for (uint32_t pos = 0; pos < size && !prog_error; pos++) {
+      var_t *e = v_elem(l, pos);
+      var_num_t x = v_getval(e);
+      switch (op) {
+      case '*':
+        x = x * n;
+        break;
+      case '/':
+        x = x / n;
+        break;
+      case '+':
+        x = x + n;
+        break;
+      case '-':
+        x = x - n;
+        break;
+      case 'R':
+        x = n - x;
+        break;
+      case 'A':
+        x = -x;
+        break;
+      default:
+        x = 0;
+        break;
+      }
+      if (!prog_error) {
+        mat_setval(e, x);
       }
     }
-    if (v_maxdim(l) == 1) {
-      mat_tov(l, m, lc, 1, 0);
-    } else {
-      mat_tov(l, m, lr, lc, 1);
-    }
-    free(m1);
-    free(m);
+    mat_reshape(l, lr, lc, v_maxdim(l));
   }
 }
 
@@ -139,45 +179,26 @@ void mat_mulN(var_t *v, var_num_t N) {
 }
 
 //
-// matrix - add/sub
+// matrix - add/sub, applied in place to the elements of l
 //
 void mat_op2(var_t *l, var_t *r, int op) {
   int32_t lr, lc, rr, rc;
 
-  var_num_t *m1 = mat_toc(l, &lr, &lc);
-  if (m1) {
-    var_num_t *m2 = mat_toc(r, &rr, &rc);
-    if (m2) {
-      var_num_t *m = NULL;
-      if (rc != lc || lr != rr) {
-        err_matdim();
-      } else {
-        m = (var_num_t *)malloc(sizeof(var_num_t) * lr * lc);
-        for (int i = 0; i < lr; i++) {
-          for (int j = 0; j < lc; j++) {
-            int pos = i * lc + j;
-            if (op == '+') {
-              m[pos] = m1[pos] + m2[pos];
-            } else {
-              m[pos] = m2[pos] - m1[pos];
-            }
-            // array is reversed because of where to store
-          }
-        }
-      }
-
-      free(m1);
-      free(m2);
-      if (m) {
-        if (v_maxdim(r) == 1) {
-          mat_tov(l, m, lc, 1, 0);
-        } else {
-          mat_tov(l, m, lr, lc, 1);
+  if (mat_dims(l, &lr, &lc) && mat_dims(r, &rr, &rc)) {
+    if (rc != lc || lr != rr || v_asize(l) != v_asize(r)) {
+      err_matdim();
+    } else {
+      uint32_t size = v_asize(l);
+      for (uint32_t pos = 0; pos < size && !prog_error; pos++) {
+        var_t *e = v_elem(l, pos);
+        var_num_t x1 = v_getval(e);
+        var_num_t x2 = v_getval(v_elem(r, pos));
+        if (!prog_error) {
+          // array is reversed because of where to store
+          mat_setval(e, op == '+' ? x1 + x2 : x2 - x1);
         }
-        free(m);
       }
-    } else {
-      free(m1);
+      mat_reshape(l, lr, lc, v_maxdim(r));
     }
   }
 }
@@ -191,15 +212,23 @@ void mat_sub(var_t *l, var_t *r) {
 }
 
 //
-// matrix: multiply two 1d arrays
+// matrix: multiply or divide the elements of two 1d arrays
 //
-void mat_mul_1d(var_t *l, var_t *r) {
+void mat_mul_1d(var_t *l, var_t *r, int op) {
   uint32_t size = v_asize(l);
-  for (uint32_t i = 0; i < size; i++) {
+  if (size != v_asize(r)) {
+    err_matdim();
+    return;
+  }
+  for (uint32_t i = 0; i < size && !prog_error; i++) {
     var_t *elem = v_elem(r, i);
     var_num_t v1 = v_getval(v_elem(l, i));
     var_num_t v2 = v_getval(elem);
-    v_setreal(elem, (v1 * v2));
+    if (op == '/' && v2 == 0) {
+      err_division_by_zero();
+    } else if (!prog_error) {
+      v_setreal(elem, op == '/' ? v1 / v2 : v1 * v2);
+    }
   }
 }
 
@@ -209,6 +238,10 @@ void mat_mul_1d(var_t *l, var_t *r) {
 void mat_dot(var_t *l, var_t *r) {
   var_num_t result = 0;
   uint32_t size = v_asize(l);
+  if (size != v_asize(r)) {
+    err_matdim();
+    return;
+  }
   for (uint32_t i = 0; i < size; i++) {
     var_num_t v1 = v_getval(v_elem(l, i));
     var_num_t v2 = v_getval(v_elem(r, i));
@@ -236,15 +269,7 @@ void mat_mul(var_t *l, var_t *r) {
         mr = lr;
         mc = rc;
         m = (var_num_t *)malloc(sizeof(var_num_t) * mr * mc);
-        for (int i = 0; i < mr; i++) {
-          for (int j = 0; j < mc; j++) {
-            int pos = i * mc + j;
-            m[pos] = 0.0;
-            for (int k = 0; k < lc; k++) {
-              m[pos] = m[pos] + (m1[i * lc + k] * m2[k * rc + j]);
-            }
-          }
-        }
+        mat_product(m1, m2, m, mr, mc, lc);
       }
       free(m1);
       free(m2);
@@ -297,9 +322,7 @@ int v_wc_match(var_t *vwc, var_t *v) {
   return ri;
 }
 
-static inline void oper_add(var_t *r, var_t *left) {
-  byte op = CODE(IP);
-  IP++;
+static inline void oper_addsub(var_t *r, var_t *left, byte op) {
   if (r->type == V_INT && v_is_type(left, V_INT)) {
     if (op == '+') {
       r->v.i += left->v.i;
@@ -335,6 +358,16 @@ static inline void oper_add(var_t *r, var_t *left) {
         } else {
           mat_sub(r, left);
         }
+      } else if (r->type == V_ARRAY && (v_is_type(left, V_INT) || v_is_type(left, V_NUM))) {
+        // scalar +/- array
+        mat_op1(r, op == '+' ? '+' : 'R', v_getval(left));
+      } else if (r->type == V_INT || r->type == V_NUM) {
+        // array +/- scalar
+        var_num_t rf = v_getval(r);
+        // take over the temporary array rather than copying it
+        v_move(r, left);
+        v_init(left);
+        mat_op1(r, op, rf);
       } else {
         err_matop();
       }
@@ -362,6 +395,12 @@ static inline void oper_add(var_t *r, var_t *left) {
   }
 }
 
+static inline void oper_add(var_t *r, var_t *left) {
+  byte op = CODE(IP);
+  IP++;
+  oper_addsub(r, left, op);
+}
+
 static inline void oper_mul(var_t *r, var_t *left) {
   var_num_t lf;
   var_num_t rf;
@@ -375,8 +414,8 @@ static inline void oper_mul(var_t *r, var_t *left) {
     // arrays
     if (r->type == V_ARRAY && v_is_type(left, V_ARRAY)) {
       if (v_maxdim(left) == v_maxdim(r) && v_maxdim(r) == 1) {
-        if (op == '*') {
-          mat_mul_1d(left, r);
+        if (op == '*' || op == '/') {
+          mat_mul_1d(left, r, op);
         } else if (op == '%') {
           mat_dot(left, r);
         } else {
@@ -396,9 +435,12 @@ static inline void oper_mul(var_t *r, var_t *left) {
         }
       } else {
         rf = v_getval(r);
-        v_set(r, left);
-        if (op == '*') {
-          mat_mulN(r, rf);
+        if (op == '/' && rf == 0) {
+          err_division_by_zero();
+        } else if (op == '*' || op == '/') {
+          v_move(r, left);
+          v_init(left);
+          mat_op1(r, op, rf);
         } else {
           err_matop();
         }
@@ -795,6 +837,8 @@ static inline void eval_var(var_t *r, var_t *var_p) {
   }
 }
 
+static inline void eval_stk_next();
+
 static inline void eval_push(var_t *r) {
   bcip_t len;
 
@@ -812,13 +856,17 @@ static inline void eval_push(var_t *r) {
     eval_stk[eval_sp].type = V_STR;
     eval_stk[eval_sp].v.p.ptr = malloc(len + 1);
     eval_stk[eval_sp].v.p.owner = 1;
-    strcpy(eval_stk[eval_sp].v.p.ptr, r->v.p.ptr);
+    memcpy(eval_stk[eval_sp].v.p.ptr, r->v.p.ptr, len);
+    eval_stk[eval_sp].v.p.ptr[len] = '\0';
     eval_stk[eval_sp].v.p.length = len;
     break;
   default:
     v_set(&eval_stk[eval_sp], r);
   }
+  eval_stk_next();
+}
 
+static inline void eval_stk_next() {
   // expression-stack resize
   eval_sp++;
   if (eval_sp == eval_size) {
@@ -831,6 +879,145 @@ static inline void eval_push(var_t *r) {
   }
 }
 
+//
+// numeric fast path for LEFT op R, where R is a constant or scalar variable.
+// returns 0 when the operands need the generic operators
+//
+static inline int eval_prim_numeric(var_t *r, var_t *right, byte opr, byte op) {
+  int is_int = (r->type == V_INT && right->type == V_INT);
+  var_num_t lf, rf;
+  if (!is_int) {
+    if ((r->type != V_INT && r->type != V_NUM) ||
+        (right->type != V_INT && right->type != V_NUM)) {
+      return 0;
+    }
+    lf = (r->type == V_INT) ? r->v.i : r->v.n;
+    rf = (right->type == V_INT) ? right->v.i : right->v.n;
+  } else {
+    lf = rf = 0;
+  }
+
+  switch (opr) {
+  case kwTYPE_ADDOPR:
+    if (is_int) {
+      r->v.i = (op == '+') ? r->v.i + right->v.i : r->v.i - right->v.i;
+    } else {
+      r->type = V_NUM;
+      r->v.n = (op == '+') ? lf + rf : lf - rf;
+    }
+    return 1;
+
+  case kwTYPE_MULOPR:
+    if (is_int) {
+      lf = r->v.i;
+      rf = right->v.i;
+    }
+    if (op == '*') {
+      r->type = V_NUM;
+      r->v.n = lf * rf;
+      return 1;
+    } else if (op == '/' && rf != 0) {
+      r->type = V_NUM;
+      r->v.n = lf / rf;
+      return 1;
+    }
+    break;
+
+  case kwTYPE_CMPOPR:
+    switch (op) {
+    case OPLOG_EQ:
+      r->v.i = (v_compare(r, right) == 0);
+      break;
+    case OPLOG_GT:
+      r->v.i = (v_compare(r, right) > 0);
+      break;
+    case OPLOG_GE:
+      r->v.i = (v_compare(r, right) >= 0);
+      break;
+    case OPLOG_LT:
+      r->v.i = (v_compare(r, right) < 0);
+      break;
+    case OPLOG_LE:
+      r->v.i = (v_compare(r, right) <= 0);
+      break;
+    case OPLOG_NE:
+      r->v.i = (v_compare(r, right) != 0);
+      break;
+    default:
+      return 0;
+    }
+    r->type = V_INT;
+    return 1;
+  }
+  return 0;
+}
+
+//
+// LEFT = R, R = constant or scalar variable, then apply the operator
+// which follows. see cev_is_simple_prim() in ceval.c
+//
+static inline void eval_prim(var_t *r) {
+  var_t num;
+  var_t *right;
+  bcip_t next;
+
+  switch (CODE(IP)) {
+  case kwTYPE_INT:
+    memcpy(&num.v.i, prog_source + IP + 1, OS_INTSZ);
+    num.type = V_INT;
+    right = &num;
+    next = IP + 1 + OS_INTSZ;
+    break;
+  case kwTYPE_NUM:
+    memcpy(&num.v.n, prog_source + IP + 1, OS_REALSZ);
+    num.type = V_NUM;
+    right = &num;
+    next = IP + 1 + OS_REALSZ;
+    break;
+  default:
+    right = tvar[code_peek32(IP + 1)];
+    next = IP + 1 + ADDRSZ;
+    break;
+  }
+
+  if (eval_prim_numeric(r, right, CODE(next), CODE(next + 1))) {
+    IP = next + 2;
+  } else {
+    // take ownership of R as the left side operand
+    var_t left = *r;
+    v_init(r);
+    switch (CODE(IP)) {
+    case kwTYPE_INT:
+    case kwTYPE_NUM:
+      IP = next;
+      v_set(r, right);
+      break;
+    default:
+      eval_var(r, code_getvarptr());
+      break;
+    }
+    if (!prog_error) {
+      byte opr = CODE(IP);
+      IP++;
+      switch (opr) {
+      case kwTYPE_ADDOPR:
+        oper_add(r, &left);
+        break;
+      case kwTYPE_MULOPR:
+        oper_mul(r, &left);
+        break;
+      case kwTYPE_CMPOPR:
+        oper_cmp(r, &left);
+        break;
+      default:
+        err_evsyntax();
+        break;
+      }
+    }
+    V_FREE2(&left);
+  }
+}
+
 static inline void eval_extf(var_t *r) {
   bcip_t lib;
   bcip_t idx;
@@ -1214,6 +1401,8 @@ static inline void eval_callf(var_t *r) {
   case kwFORMAT:
   case kwBGETC:
   case kwSEQ:
+  case kwREGEX:
+  case kwQUANTILE:
   case kwIMAGE:
   case kwFORM:
   case kwWINDOW:
@@ -1237,7 +1426,6 @@ static inline void eval_callf(var_t *r) {
 
 //
 // executes the expression (Code[IP]) and returns the result (r)
-//
 void eval(var_t *r) {
   var_t *left = NULL;
   bcip_t eval_pos = eval_sp;
@@ -1367,6 +1555,12 @@ void eval(var_t *r) {
       eval_ptr(r);
       break;
 
+    case kwTYPE_EVPRIM:
+      // left = result, result = operand
+      IP++;
+      eval_prim(r);
+      break;
+
     case kwBYREF:
       // unexpected code
       err_evsyntax();
@@ -1395,3 +1589,65 @@ void eval(var_t *r) {
   // restore stack pointer
   eval_sp = eval_pos;
 }
+
+//
+// v = v + x [+ y ...] compiled as kwLET_APPEND. each term is either
+// [kwTYPE_EVPRIM prim] or [kwTYPE_EVPUSH expr kwTYPE_EOC] followed by
+// [kwTYPE_ADDOPR '+']. the terms are evaluated onto the stack before v
+// changes, since a BYREF parameter could refer to v. strings are then
+// appended to v without copying v, otherwise the terms are added as they
+// would be by eval()
+//
+void eval_append(var_t *v_left) {
+  bcip_t eval_pos = eval_sp;
+  while (!prog_error && (CODE_PEEK() == kwTYPE_EVPRIM || CODE_PEEK() == kwTYPE_EVPUSH)) {
+    var_t r;
+    v_init(&r);
+    if (CODE(IP++) == kwTYPE_EVPRIM) {
+      switch (CODE_PEEK()) {
+      case kwTYPE_INT:
+        r.type = V_INT;
+        memcpy(&r.v.i, prog_source + IP + 1, OS_INTSZ);
+        IP += 1 + OS_INTSZ;
+        break;
+      case kwTYPE_NUM:
+        r.type = V_NUM;
+        memcpy(&r.v.n, prog_source + IP + 1, OS_REALSZ);
+        IP += 1 + OS_REALSZ;
+        break;
+      default:
+        eval_var(&r, code_getvarptr());
+        break;
+      }
+    } else {
+      eval(&r);
+      // skip the kwTYPE_EOC which replaced kwTYPE_EVPOP
+      IP++;
+    }
+
+    // skip kwTYPE_ADDOPR '+'
+    IP += 2;
+
+    // the stack takes ownership of the term
+    eval_stk[eval_sp] = r;
+    eval_stk_next();
+  }
+
+  for (bcip_t i = eval_pos; i < eval_sp; i++) {
+    var_t *r = &eval_stk[i];
+    if (prog_error) {
+      V_FREE(r);
+    } else if (v_left->type == V_STR && r->type == V_STR) {
+      v_strappend(v_left, r->v.p.ptr, v_strlen(r));
+      V_FREE(r);
+    } else {
+      var_t left;
+      v_init(&left);
+      v_set(&left, v_left);
+      oper_addsub(r, &left, '+');
+      v_move(v_left, r);
+      v_init(r);
+    }
+  }
+  eval_sp = eval_pos;
+}
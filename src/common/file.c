@@ -27,8 +27,11 @@
 #include "common/fs_socket_client.h"
 #include "lib/match.h"
 
-// FILE TABLE
-static dev_file_t file_table[OS_FILEHANDLES];
+// FILE TABLE, the handles after OS_FILEHANDLES are not visible to the user
+static dev_file_t file_table[OS_FILEHANDLES + OS_HIDDEN_FILEHANDLES];
+
+// set while the dev_f..._hidden functions access the hidden handles
+static int file_hidden_access = 0;
 
 /*
  * returns the last-modified time of the file
@@ -134,7 +137,7 @@ int wc_match(const char *mask, char *name) {
  * initialize file system
  */
 int dev_initfs() {
-  for (int i = 0; i < OS_FILEHANDLES; i++) {
+  for (int i = 0; i < OS_FILEHANDLES + OS_HIDDEN_FILEHANDLES; i++) {
     file_table[i].handle = -1;
   }
 
@@ -145,11 +148,13 @@ int dev_initfs() {
  * cleanup file system
  */
 void dev_closefs() {
-  for (int i = 0; i < OS_FILEHANDLES; i++) {
+  file_hidden_access = 1;
+  for (int i = 0; i < OS_FILEHANDLES + OS_HIDDEN_FILEHANDLES; i++) {
     if (file_table[i].handle != -1) {
       dev_fclose(i + 1);
     }
   }
+  file_hidden_access = 0;
 }
 
 /**
@@ -174,7 +179,8 @@ dev_file_t *dev_getfileptr(const int handle) {
   dev_file_t *result;
   // BASIC handles start from 1
   int hnd = handle - 1;
-  if (hnd < 0 || hnd >= OS_FILEHANDLES) {
+  int count = file_hidden_access ? OS_FILEHANDLES + OS_HIDDEN_FILEHANDLES : OS_FILEHANDLES;
+  if (hnd < 0 || hnd >= count) {
     rt_raise(FSERR_HANDLE);
     result = NULL;
   } else {
@@ -345,6 +351,26 @@ int dev_fclose(int sb_handle) {
   return 0;
 }
 
+/**
+ * returns true on success
+ */
+int dev_fflush(int sb_handle) {
+  dev_file_t *f;
+
+  if ((f = dev_getfileptr(sb_handle)) == NULL) {
+    return 0;
+  }
+
+  switch (f->type) {
+  case ft_stream:
+    return stream_flush(f);
+  default:
+    // the other drivers are unbuffered
+    break;
+  }
+  return 1;
+}
+
 /**
  * returns true on success
  */
@@ -393,6 +419,81 @@ int dev_fread(int sb_handle, byte *data, uint32_t size) {
   return 0;
 }
 
+/**
+ * reads the next line into the string variable, without the line ending.
+ * returns false at the end of the file
+ */
+int dev_freadln(int sb_handle, var_t *var) {
+  dev_file_t *f;
+
+  if ((f = dev_getfileptr(sb_handle)) == NULL) {
+    return 0;
+  }
+  if (f->type == ft_stream && f->buffer != NULL) {
+    return stream_read_line(f, var);
+  }
+
+  int result = 0;
+  byte ch;
+  v_setstr(var, "");
+  while (!dev_feof(sb_handle)) {
+    dev_fread(sb_handle, &ch, 1);
+    if (prog_error) {
+      break;
+    }
+    result = 1;
+    if (ch == '\n') {
+      break;
+    } else if (ch != '\r') {
+      v_strappend(var, (const char *)&ch, 1);
+    }
+  }
+  return result;
+}
+
+/**
+ * opens a file on a handle outside the range of user's handles
+ *
+ * returns the handle on success, otherwise 0
+ */
+int dev_fopen_hidden(const char *name, int flags) {
+  int handle = 0;
+  for (int i = OS_FILEHANDLES; i < OS_FILEHANDLES + OS_HIDDEN_FILEHANDLES; i++) {
+    if (file_table[i].handle == -1) {
+      handle = i + 1;
+      break;
+    }
+  }
+  if (!handle) {
+    rt_raise(FSERR_TOO_MANY_FILES);
+    return 0;
+  }
+  file_hidden_access = 1;
+  int success = dev_fopen(handle, name, flags);
+  file_hidden_access = 0;
+  return success ? handle : 0;
+}
+
+/**
+ * reads the next line from a file opened with dev_fopen_hidden
+ */
+int dev_freadln_hidden(int sb_handle, var_t *var) {
+  file_hidden_access = 1;
+  int result = dev_freadln(sb_handle, var);
+  file_hidden_access = 0;
+  return result;
+}
+
+/**
+ * closes a file opened with dev_fopen_hidden
+ */
+int dev_fclose_hidden(int sb_handle) {
+  file_hidden_access = 1;
+  int result = dev_fclose(sb_handle);
+  file_hidden_access = 0;
+  return result;
+}
+
 /**
  *
  */
@@ -15,6 +15,7 @@
 
 #if defined(_UnixOS)
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 #include <dirent.h>
@@ -25,6 +26,9 @@
 
 #include "common/fs_stream.h"
 
+// size of the buffer used for regular files
+#define STREAM_BUFSIZE 65536
+
 /*
  * open a file
  */
@@ -80,16 +84,58 @@ int stream_open(dev_file_t *f) {
 
   if (f->handle < 0) {
     err_file((f->last_error = errno));
+  } else {
+    // only regular files are buffered, devices and pipes are used as they are
+    struct stat st;
+    if (f->handle > 2 && fstat(f->handle, &st) == 0 && S_ISREG(st.st_mode)) {
+      f->buffer = malloc(STREAM_BUFSIZE);
+    }
+    f->buf_pos = 0;
+    f->buf_len = 0;
+    f->buf_dirty = 0;
   }
   return (f->handle >= 0);
 }
 
+/*
+ * writes the buffered output or discards the unread input, leaving the
+ * os file position at the logical position
+ */
+static int stream_sync(dev_file_t *f) {
+  int result = 1;
+  if (f->buf_dirty) {
+    int r = write(f->handle, f->buffer, f->buf_pos);
+    if (r != (int)f->buf_pos) {
+      err_file((f->last_error = errno));
+      result = 0;
+    }
+    f->buf_dirty = 0;
+  } else if (f->buf_pos < f->buf_len) {
+    lseek(f->handle, (off_t)f->buf_pos - (off_t)f->buf_len, SEEK_CUR);
+  }
+  f->buf_pos = 0;
+  f->buf_len = 0;
+  return result;
+}
+
+/*
+ * writes the buffered output
+ */
+int stream_flush(dev_file_t *f) {
+  return f->buffer == NULL || !f->buf_dirty || stream_sync(f);
+}
+
 /*
  *   close the stream
  */
 int stream_close(dev_file_t *f) {
   int r;
 
+  if (f->buffer != NULL) {
+    stream_flush(f);
+    free(f->buffer);
+    f->buffer = NULL;
+  }
   r = close(f->handle);
   f->handle = -1;
   if (r) {
@@ -103,6 +149,22 @@ int stream_close(dev_file_t *f) {
 int stream_write(dev_file_t *f, byte *data, uint32_t size) {
   int r;
 
+  if (f->buffer != NULL) {
+    if (!f->buf_dirty) {
+      // discard any read-ahead
+      stream_sync(f);
+    }
+    if (f->buf_pos + size > STREAM_BUFSIZE && !stream_sync(f)) {
+      return 0;
+    }
+    if (size < STREAM_BUFSIZE) {
+      memcpy(f->buffer + f->buf_pos, data, size);
+      f->buf_pos += size;
+      f->buf_dirty = 1;
+      return 1;
+    }
+  }
+
   r = write(f->handle, data, size);
   if (r != (int) size) {
     err_file((f->last_error = errno));
@@ -115,6 +177,39 @@ int stream_write(dev_file_t *f, byte *data, uint32_t size) {
 int stream_read(dev_file_t *f, byte *data, uint32_t size) {
   int r;
 
+  if (f->buffer != NULL) {
+    if (f->buf_dirty && !stream_sync(f)) {
+      return 0;
+    }
+    uint32_t count = 0;
+    while (count < size) {
+      uint32_t avail = f->buf_len - f->buf_pos;
+      if (avail == 0) {
+        if (size - count >= STREAM_BUFSIZE) {
+          // too large to buffer
+          r = read(f->handle, data + count, size - count);
+          count += (r > 0 ? r : 0);
+          break;
+        }
+        r = read(f->handle, f->buffer, STREAM_BUFSIZE);
+        f->buf_pos = 0;
+        f->buf_len = (r > 0 ? r : 0);
+        if (r <= 0) {
+          break;
+        }
+        avail = f->buf_len;
+      }
+      uint32_t len = avail < size - count ? avail : size - count;
+      memcpy(data + count, f->buffer + f->buf_pos, len);
+      f->buf_pos += len;
+      count += len;
+    }
+    if (count != size) {
+      err_file((f->last_error = errno));
+    }
+    return (count == size);
+  }
+
   r = read(f->handle, data, size);
   if (r != (int) size) {
     err_file((f->last_error = errno));
@@ -122,11 +217,64 @@ int stream_read(dev_file_t *f, byte *data, uint32_t size) {
   return (r == (int) size);
 }
 
+/*
+ * reads the next line into the string variable, reusing its storage. the
+ * '\n' is consumed and any '\r' removed. returns false at the end of the file
+ */
+int stream_read_line(dev_file_t *f, var_t *var) {
+  int result = 0;
+
+  if (var->type != V_STR || !var->v.p.owner) {
+    v_free(var);
+    v_init_str(var, 0);
+  } else {
+    var->v.p.ptr[0] = '\0';
+    var->v.p.length = 1;
+  }
+  if (f->buf_dirty && !stream_sync(f)) {
+    return 0;
+  }
+  for (;;) {
+    if (f->buf_pos == f->buf_len) {
+      int r = read(f->handle, f->buffer, STREAM_BUFSIZE);
+      f->buf_pos = 0;
+      f->buf_len = (r > 0 ? r : 0);
+      if (r <= 0) {
+        break;
+      }
+    }
+    result = 1;
+    const char *start = (const char *)f->buffer + f->buf_pos;
+    const char *end = (const char *)f->buffer + f->buf_len;
+    const char *eol = memchr(start, '\n', end - start);
+    if (eol != NULL) {
+      f->buf_pos += eol - start + 1;
+      end = eol;
+    } else {
+      f->buf_pos = f->buf_len;
+    }
+    while (start < end) {
+      // append up to the next '\r'
+      const char *cr = memchr(start, '\r', end - start);
+      const char *next = cr != NULL ? cr : end;
+      v_strappend(var, start, next - start);
+      start = next + 1;
+    }
+    if (eol != NULL) {
+      break;
+    }
+  }
+  return result;
+}
+
 /*
  * returns the current position
  */
 uint32_t stream_tell(dev_file_t *f) {
-  return lseek(f->handle, 0, SEEK_CUR);
+  if (f->buf_dirty) {
+    stream_sync(f);
+  }
+  return lseek(f->handle, 0, SEEK_CUR) - (f->buf_len - f->buf_pos);
 }
 
 /*
@@ -135,6 +283,9 @@ uint32_t stream_tell(dev_file_t *f) {
 uint32_t stream_length(dev_file_t *f) {
   long pos, endpos;
 
+  if (f->buf_dirty) {
+    stream_sync(f);
+  }
   pos = lseek(f->handle, 0, SEEK_CUR);
   if (pos != -1) {
     endpos = lseek(f->handle, 0, SEEK_END);
@@ -149,6 +300,9 @@ uint32_t stream_length(dev_file_t *f) {
 /*
  */
 uint32_t stream_seek(dev_file_t *f, uint32_t offset) {
+  if (f->buffer != NULL) {
+    stream_sync(f);
+  }
   return lseek(f->handle, offset, SEEK_SET);
 }
 
@@ -157,6 +311,19 @@ uint32_t stream_seek(dev_file_t *f, uint32_t offset) {
 int stream_eof(dev_file_t *f) {
   long pos, endpos;
 
+  if (f->buffer != NULL) {
+    if (f->buf_pos < f->buf_len) {
+      return 0;
+    }
+    if (!(f->open_flags & (DEV_FILE_OUTPUT | DEV_FILE_APPEND))) {
+      // refill the buffer rather than seeking to the end and back
+      int r = read(f->handle, f->buffer, STREAM_BUFSIZE);
+      f->buf_pos = 0;
+      f->buf_len = (r > 0 ? r : 0);
+      return (f->buf_len == 0);
+    }
+    stream_sync(f);
+  }
   pos = lseek(f->handle, 0, SEEK_CUR);
   if (pos != -1) {
     endpos = lseek(f->handle, 0, SEEK_END);
@@ -167,3 +334,45 @@ int stream_eof(dev_file_t *f) {
   }
   return 1;
 }
+
+/*
+ * maps the remainder of the file into memory and moves the file position
+ * to the end. returns false when the file can't be mapped
+ */
+int stream_map(dev_file_t *f, stream_map_t *map) {
+  int result = 0;
+#if defined(_UnixOS)
+  struct stat st;
+  if (f->buffer != NULL && fstat(f->handle, &st) == 0 && st.st_size <= UINT32_MAX) {
+    uint32_t pos = stream_tell(f);
+    map->size = st.st_size;
+    map->offset = pos < map->size ? pos : map->size;
+    if (map->offset == map->size) {
+      map->base = NULL;
+      result = 1;
+    } else {
+      // mmap offsets must be page aligned, so map the whole file
+      map->base = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, f->handle, 0);
+      if (map->base != MAP_FAILED) {
+        madvise(map->base, map->size, MADV_SEQUENTIAL);
+        result = 1;
+      }
+    }
+    if (result) {
+      stream_seek(f, map->size);
+    }
+  }
+#endif
+  return result;
+}
+
+/*
+ * releases the memory mapped by stream_map()
+ */
+void stream_unmap(stream_map_t *map) {
+#if defined(_UnixOS)
+  if (map->base != NULL) {
+    munmap(map->base, map->size);
+  }
+#endif
+}
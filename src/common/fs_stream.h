@@ -21,5 +21,19 @@ uint32_t stream_tell(dev_file_t *f);
 uint32_t stream_length(dev_file_t *f);
 uint32_t stream_seek(dev_file_t *f, uint32_t offset);
 int stream_eof(dev_file_t *f);
+int stream_flush(dev_file_t *f);
+int stream_read_line(dev_file_t *f, var_t *var);
+
+/*
+ * a read-only view of a file from the current position to the end
+ */
+typedef struct {
+  char *base;
+  uint32_t size;
+  uint32_t offset;
+} stream_map_t;
+
+int stream_map(dev_file_t *f, stream_map_t *map);
+void stream_unmap(stream_map_t *map);
 
 #endif
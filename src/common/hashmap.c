@@ -14,48 +14,50 @@
 #include "common/smbas.h"
 #include "common/hashmap.h"
 
-#define MAP_SIZE 32
+// initial number of slots and nodes
+#define MAP_SIZE 8
+#define MAP_BLOCK_SIZE 4
+
+// maximum percentage of used slots
+#define MAP_LOAD 70
+
+// the capacity doubles with each block, so 32 blocks can hold any 32 bit count
+#define MAP_MAX_BLOCKS 32
 
 /**
- * Our internal tree element node
+ * Our internal map element, the key and value are stored inline
  */
 typedef struct Node {
-  var_p_t key;
-  var_p_t value;
-  struct Node *left, *right;
+  var_t key;
+  var_t value;
 } Node;
 
 /**
- * Returns a new tree node
+ * Open addressing slot with the cached hash of the key
  */
-Node *tree_create_node(var_p_t key) {
-  Node *node = (Node *)malloc(sizeof(Node));
-  node->key = key;
-  node->value = NULL;
-  node->left = NULL;
-  node->right = NULL;
-  return node;
-}
+typedef struct Slot {
+  uint32_t hash;
+  Node *node;
+} Slot;
 
 /**
- * cleanup the given element
+ * The nodes are held in blocks which never move, so the key and value
+ * pointers returned to the callers stay valid when the slots are resized.
+ * The first block is allocated along with the map, after that each new
+ * block doubles the capacity. The nodes are visited in the order they
+ * were added.
  */
-void tree_delete_node(Node *node) {
-  // cleanup v_new
-  v_free(node->key);
-  v_detach(node->key);
-
-  // cleanup v_new
-  if (node->value) {
-    v_free(node->value);
-    v_detach(node->value);
-  }
+typedef struct Map {
+  Slot *slots;
+  Node *blocks[MAP_MAX_BLOCKS];
+  uint32_t size;
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t first;
+  uint32_t block_count;
+} Map;
 
-  // cleanup the node
-  free(node);
-}
-
-static inline int tree_compare(const char *key, int length, var_p_t vkey) {
+static inline int node_compare(const char *key, int length, var_p_t vkey) {
   int len1 = length;
   if (len1 && key[len1 - 1] == '\0') {
     len1--;
@@ -67,55 +69,123 @@ static inline int tree_compare(const char *key, int length, var_p_t vkey) {
   return strcaselessn(key, len1, vkey->v.p.ptr, len2);
 }
 
-void tree_destroy(Node *node) {
-  if (node->left != NULL) {
-    tree_destroy(node->left);
-  }
-  if (node->right != NULL) {
-    tree_destroy(node->right);
+int hashmap_get_hash(const char *key, int length) {
+  uint64_t hash = 1;
+  for (int i = 0; i < length && key[i] != '\0'; i++) {
+    hash += to_lower(key[i]);
+    hash <<= 3;
+    hash ^= (hash >> 3);
   }
-  tree_delete_node(node);
+  return hash;
 }
 
-Node *tree_search(Node **rootp, const char *key, int length) {
-  while (*rootp != NULL) {
-    int r = tree_compare(key, length, (*rootp)->key);
-    if (r == 0) {
-      return *rootp;
-    }
-    rootp = (r < 0) ? &(*rootp)->left : &(*rootp)->right;
+static inline uint32_t map_block_size(Map *m, uint32_t block) {
+  return block == 0 ? m->first : m->first << (block - 1);
+}
+
+/**
+ * returns the number of slots required to hold count nodes
+ */
+static uint32_t map_slots(uint32_t count) {
+  uint32_t result = MAP_SIZE;
+  while (result * MAP_LOAD / 100 <= count) {
+    result <<= 1;
   }
-  Node *result = tree_create_node(NULL);
-  *rootp = result;
   return result;
 }
 
-Node *tree_find(Node **rootp, const char *key, int length) {
-  while (*rootp != NULL) {
-    int r = tree_compare(key, length, (*rootp)->key);
-    if (r == 0) {
-      return *rootp;
+/**
+ * doubles the number of slots. only the slots are moved, not the nodes
+ */
+static void map_grow(Map *m) {
+  Slot *slots = m->slots;
+  uint32_t size = m->size;
+  m->size <<= 1;
+  m->slots = (Slot *)calloc(m->size, sizeof(Slot));
+
+  uint32_t mask = m->size - 1;
+  for (uint32_t i = 0; i < size; i++) {
+    if (slots[i].node != NULL) {
+      uint32_t index = slots[i].hash & mask;
+      while (m->slots[index].node != NULL) {
+        index = (index + 1) & mask;
+      }
+      m->slots[index] = slots[i];
     }
-    rootp = (r < 0) ? &(*rootp)->left : &(*rootp)->right;
   }
-  return NULL;
+  free(slots);
 }
 
-int tree_foreach(const Node *nodep, hashmap_foreach_func func, hashmap_cb *data) {
-  if (nodep != NULL) {
-    if (nodep->left != NULL && !tree_foreach(nodep->left, func, data)) {
-      return 0;
-    }
+/**
+ * returns the hash used for the slots
+ */
+static inline uint32_t map_hash(const char *key, int length) {
+  // spread the case-insensitive hash over the low bits used for the mask
+  uint32_t hash = hashmap_get_hash(key, length);
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6b;
+  hash ^= hash >> 13;
+  return hash;
+}
 
-    if (func(data, nodep->key, nodep->value)) {
-      return 0;
-    }
+/**
+ * returns the slot for the key, either holding the key or the empty slot
+ * where the key belongs
+ */
+static inline Slot *map_find_slot(Map *m, const char *key, int length, uint32_t hash) {
+  uint32_t mask = m->size - 1;
+  uint32_t index = hash & mask;
+  Slot *slot = &m->slots[index];
+  while (slot->node != NULL &&
+         (slot->hash != hash || node_compare(key, length, &slot->node->key) != 0)) {
+    index = (index + 1) & mask;
+    slot = &m->slots[index];
+  }
+  return slot;
+}
+
+/**
+ * adds a new node into the empty slot
+ */
+static Node *map_add_node(Map *m, Slot *slot, uint32_t hash) {
+  if (m->count == m->capacity) {
+    uint32_t size = m->capacity;
+    m->blocks[m->block_count++] = (Node *)malloc(size * sizeof(Node));
+    m->capacity += size;
+  }
+  uint32_t last = m->block_count - 1;
+  Node *node = &m->blocks[last][m->count - (m->capacity - map_block_size(m, last))];
+  v_init(&node->key);
+  v_init(&node->value);
+  node->key.pooled = 0;
+  node->value.pooled = 0;
+  slot->hash = hash;
+  slot->node = node;
+  m->count++;
+  return node;
+}
 
-    if (nodep->right != NULL && !tree_foreach(nodep->right, func, data)) {
-      return 0;
+/**
+ * returns the node for the key, adding a new node with an empty key when not found
+ */
+static inline Node *hashmap_search(var_p_t map, const char *key, int length, uint32_t hash) {
+  Map *m = (Map *)map->v.m.map;
+  Slot *slot = map_find_slot(m, key, length, hash);
+  Node *result = slot->node;
+  if (result == NULL) {
+    if (m->count >= m->size * MAP_LOAD / 100) {
+      map_grow(m);
+      slot = map_find_slot(m, key, length, hash);
     }
+    result = map_add_node(m, slot, hash);
   }
-  return 1;
+  return result;
+}
+
+static inline Node *hashmap_find(var_p_t map, const char *key) {
+  Map *m = (Map *)map->v.m.map;
+  int length = strlen(key);
+  return map_find_slot(m, key, length, map_hash(key, length))->node;
 }
 
 /**
@@ -123,102 +193,64 @@ int tree_foreach(const Node *nodep, hashmap_foreach_func func, hashmap_cb *data)
  */
 void hashmap_create(var_p_t map, int size) {
   v_free(map);
+  uint32_t first = size > MAP_BLOCK_SIZE ? size : MAP_BLOCK_SIZE;
+  Map *m = (Map *)malloc(sizeof(Map) + first * sizeof(Node));
+  m->size = map_slots(size);
+  m->slots = (Slot *)calloc(m->size, sizeof(Slot));
+  m->blocks[0] = (Node *)(m + 1);
+  m->count = 0;
+  m->capacity = first;
+  m->first = first;
+  m->block_count = 1;
+
   map->type = V_MAP;
-  map->v.m.count = 0;
   map->v.m.id = -1;
   map->v.m.lib_id = -1;
   map->v.m.cls_id = -1;
-  if (size == 0) {
-    map->v.m.size = MAP_SIZE;
-  } else {
-    map->v.m.size = (size * 100) / 75;
-  }
-  map->v.m.map = calloc(map->v.m.size, sizeof(Node *));
+  map->v.m.map = m;
 }
 
 int hashmap_destroy(var_p_t var_p) {
   if (var_p->type == V_MAP && var_p->v.m.map != NULL) {
-    Node **table = (Node **)var_p->v.m.map;
-    for (int i = 0; i < var_p->v.m.size; i++) {
-      if (table[i] != NULL) {
-        tree_destroy(table[i]);
+    Map *m = (Map *)var_p->v.m.map;
+    uint32_t remain = m->count;
+    for (uint32_t b = 0; b < m->block_count; b++) {
+      Node *block = m->blocks[b];
+      for (uint32_t i = 0; remain && i < map_block_size(m, b); i++, remain--) {
+        v_free(&block[i].key);
+        v_free(&block[i].value);
+      }
+      if (b) {
+        free(block);
       }
     }
-    free(var_p->v.m.map);
+    free(m->slots);
+    free(m);
   }
   return 0;
 }
 
-int hashmap_get_hash(const char *key, int length) {
-  uint64_t hash = 1;
-  for (int i = 0; i < length && key[i] != '\0'; i++) {
-    hash += to_lower(key[i]);
-    hash <<= 3;
-    hash ^= (hash >> 3);
-  }
-  return hash;
-}
-
-static inline Node *hashmap_search(var_p_t map, const char *key, int length) {
-  int index = hashmap_get_hash(key, length) % map->v.m.size;
-  Node **table = (Node **)map->v.m.map;
-  Node *result = table[index];
-  if (result == NULL) {
-    // new entry
-    result = table[index] = tree_create_node(NULL);
-  } else {
-    int r = tree_compare(key, length, result->key);
-    if (r < 0) {
-      result = tree_search(&result->left, key, length);
-    } else if (r > 0) {
-      result = tree_search(&result->right, key, length);
-    }
+var_p_t hashmap_put(var_p_t map, const char *key, int length) {
+  Node *node = hashmap_search(map, key, length, map_hash(key, length));
+  if (node->key.type != V_STR) {
+    v_setstrn(&node->key, key, length);
   }
-  return result;
+  return &node->value;
 }
 
-static inline Node *hashmap_find(var_p_t map, const char *key) {
-  int length = strlen(key);
-  int index = hashmap_get_hash(key, length) % map->v.m.size;
-  Node **table = (Node **)map->v.m.map;
-  Node *result = table[index];
-  if (result != NULL) {
-    int r = tree_compare(key, length, result->key);
-    if (r < 0 && result->left != NULL) {
-      result = tree_find(&result->left, key, length);
-    } else if (r > 0 && result->right != NULL) {
-      result = tree_find(&result->right, key, length);
-    } else if (r != 0) {
-      result = NULL;
-    }
-  }
-  return result;
+uint32_t hashmap_field_hash(const char *key, int length) {
+  return map_hash(key, length);
 }
 
-var_p_t hashmap_put(var_p_t map, const char *key, int length) {
-  Node *node = hashmap_search(map, key, length);
-  if (node->key == NULL) {
-    node->key = v_new();
-    node->value = v_new();
-    v_setstrn(node->key, key, length);
-    map->v.m.count++;
+var_p_t hashmap_putc(var_p_t map, const char *key, int length, uint32_t hash) {
+  Node *node = hashmap_search(map, key, length, hash);
+  if (node->key.type != V_STR) {
+    node->key.type = V_STR;
+    node->key.v.p.length = length;
+    node->key.v.p.ptr = (char *)key;
+    node->key.v.p.owner = 0;
   }
-  return node->value;
-}
-
-var_p_t hashmap_putc(var_p_t map, const char *key, int length) {
-  Node *node = hashmap_search(map, key, length);
-  if (node->key == NULL) {
-    var_t *var_key = v_new();
-    var_key->type = V_STR;
-    var_key->v.p.length = length;
-    var_key->v.p.ptr = (char *)key;
-    var_key->v.p.owner = 0;
-    node->key = var_key;
-    node->value = v_new();
-    map->v.m.count++;
-  }
-  return node->value;
+  return &node->value;
 }
 
 var_p_t hashmap_putv(var_p_t map, const var_p_t key) {
@@ -228,37 +260,55 @@ var_p_t hashmap_putv(var_p_t map, const var_p_t key) {
     v_tostr(key);
   }
 
-  Node *node = hashmap_search(map, key->v.p.ptr, key->v.p.length);
-  if (node->key == NULL) {
-    node->key = key;
-    node->value = v_new();
-    map->v.m.count++;
+  Node *node = hashmap_search(map, key->v.p.ptr, key->v.p.length,
+                              map_hash(key->v.p.ptr, key->v.p.length));
+  if (node->key.type != V_STR) {
+    // move the key into the node
+    node->key.type = V_STR;
+    node->key.v.p = key->v.p;
   } else {
     // discard unused key
     v_free(key);
-    v_detach(key);
   }
-  return node->value;
+  v_detach(key);
+  return &node->value;
 }
 
 var_p_t hashmap_get(var_p_t map, const char *key) {
-  var_p_t result;
   Node *node = hashmap_find(map, key);
-  if (node != NULL) {
-    result = node->value;
-  } else {
-    result = NULL;
+  return node != NULL ? &node->value : NULL;
+}
+
+uint32_t hashmap_count(var_p_t map) {
+  return ((Map *)map->v.m.map)->count;
+}
+
+var_p_t hashmap_get_key(var_p_t map, int index) {
+  var_p_t result = NULL;
+  if (map && map->type == V_MAP && index >= 0) {
+    Map *m = (Map *)map->v.m.map;
+    uint32_t pos = index;
+    for (uint32_t b = 0; pos < m->count && b < m->block_count; b++) {
+      uint32_t size = map_block_size(m, b);
+      if (pos < size) {
+        result = &m->blocks[b][pos].key;
+        break;
+      }
+      pos -= size;
+    }
   }
   return result;
 }
 
 void hashmap_foreach(var_p_t map, hashmap_foreach_func func, hashmap_cb *data) {
   if (map && map->type == V_MAP) {
-    Node **table = (Node **)map->v.m.map;
-    for (int i = 0; i < map->v.m.size; i++) {
-      if (table[i] != NULL) {
-        if (!tree_foreach(table[i], func, data)) {
-          break;
+    Map *m = (Map *)map->v.m.map;
+    uint32_t remain = m->count;
+    for (uint32_t b = 0; b < m->block_count; b++) {
+      Node *block = m->blocks[b];
+      for (uint32_t i = 0; remain && i < map_block_size(m, b); i++, remain--) {
+        if (func(data, &block[i].key, &block[i].value)) {
+          return;
         }
       }
     }
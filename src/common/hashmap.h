@@ -26,12 +26,15 @@ typedef struct hashmap_cb {
 
 typedef int (*hashmap_foreach_func)(hashmap_cb *cb, var_p_t k, var_p_t v);
 
+uint32_t hashmap_field_hash(const char *key, int length);
 void hashmap_create(var_p_t map, int size);
 int  hashmap_destroy(var_p_t map);
 var_p_t hashmap_put(var_p_t map, const char *key, int length);
-var_p_t hashmap_putc(var_p_t map, const char *key, int length);
+var_p_t hashmap_putc(var_p_t map, const char *key, int length, uint32_t hash);
 var_p_t hashmap_putv(var_p_t map, const var_p_t key);
 var_p_t hashmap_get(var_p_t map, const char *key);
+uint32_t hashmap_count(var_p_t map);
+var_p_t hashmap_get_key(var_p_t map, int index);
 void hashmap_foreach(var_p_t map, hashmap_foreach_func func, hashmap_cb *data);
 
 #endif /* !_HASHMAP_H_ */
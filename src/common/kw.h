@@ -85,7 +85,7 @@ enum keyword {
   kwTYPE_PARAM, /* Parameters */
   kwTYPE_CALLP, /* Call a build-in procedure */
   kwTYPE_EOC, /* End-Of-Command mark */
-  kwTYPE_UDS_EL, /* Structure element */
+  kwTYPE_UDS_EL, /* Structure element: [4B-hash] followed by the name */
   kwTYPE_SEP, /* Separator */
   kwTYPE_LINE, /* Debug info: SOURCE LINE */
   kwLOCAL, /* Create local variables */
@@ -176,6 +176,10 @@ enum keyword {
   kwCATCH,
   kwENDTRY,
   kwFUNC_RETURN,
+  kwTYPE_EVPRIM, /* L = R, R = constant or scalar variable */
+  kwLET_APPEND, /* v = v + x [+ y ...] */
+  kwFLUSH,
+  kwFILE, /* FOR v IN FILE(path) */
   kwNULL
 };
 
@@ -246,6 +250,8 @@ enum proc_keywords {
   kwDEFINEKEY,
   kwSHOWPAGE,
   kwTHROW,
+  kwBSEARCH,
+  kwCSVSPLIT,
   kwNULLPROC,
   kwTICKSP
 };
@@ -404,6 +410,8 @@ enum func_keywords {
   kwIMAGE,
   kwFORM,
   kwTIMESTAMP,
+  kwREGEX,
+  kwQUANTILE,
   kwNULLFUNC
 };
 
@@ -64,16 +64,14 @@ void cmd_plot() {
   // execute user's expression for each element
   // get y values
   if (use_ip != INVALID_ADDR) {
-    var_t v;
+    usefunc_t uf;
 
-    for (i = 0, x = xmin; i < count && !prog_error; i++, x += xstep) {
-      v_init(&v);
-      v_setreal(&v, x);
-      exec_usefunc(&v, use_ip);
+    for (i = 0, x = xmin; i < count; i++, x += xstep) {
       xt[i] = x;
-      yt[i] = v_getreal(&v);
-      v_free(&v);
     }
+    exec_usefunc_begin(&uf, use_ip, 1);
+    exec_usefunc_vec(&uf, xt, yt, count);
+    exec_usefunc_end(&uf);
 
     // jmp to correct location
     code_jump(exit_ip);
@@ -40,6 +40,7 @@ typedef int (*sblib_exec_fn)(int, int, slib_par_t *, var_t *);
 typedef int (*sblib_getname_fn) (int, char *);
 typedef int (*sblib_count_fn) (void);
 typedef int (*sblib_init_fn) (const char *);
+typedef int (*sblib_version_fn) (void);
 typedef int (*sblib_has_window_ui_fn) (void);
 typedef int (*sblib_free_fn) (int, int);
 typedef int (*sblib_refresh_id_fn) (int, int);
@@ -176,7 +177,19 @@ static int slib_open(const char *path, const char *name, const char *alias, int
     log_printf("LIB: registering '%s'", fullname);
   }
 
-  return slib_llopen(lib);
+  int result = slib_llopen(lib);
+#if !defined(_MCU)
+  if (result) {
+    // reject libraries built with an older var_t
+    sblib_version_fn version = slib_getoptptr(lib, "sblib_version");
+    if (version == NULL || version() != SBLIB_VERSION) {
+      sc_raise("LIB: %s was built for another version of SmallBASIC\n", lib->_name);
+      slib_llclose(lib);
+      result = 0;
+    }
+  }
+#endif
+  return result;
 }
 
 //
@@ -65,6 +65,15 @@ void bc_loop(int isf);
  */
 void eval(var_t *result);
 
+/**
+ * @ingroup exec
+ *
+ * evaluate the terms of v = v + x [+ y ...] and add them to v in place
+ *
+ * @param v_left the variable to update
+ */
+void eval_append(var_t *v_left);
+
 /**
  * @ingroup exec
  *
@@ -378,6 +387,79 @@ void exec_usefunc(var_t *var, bcip_t ip);
  */
 void exec_usefunc2(var_t *var1, var_t *var2, bcip_t ip);
 
+/**
+ * @ingroup par
+ *
+ * state of a user's expression evaluated over many points
+ */
+typedef struct usefunc_t {
+  bcip_t ip;              /**< the expression's address */
+  var_t *old_x;           /**< the saved X */
+  var_t *old_y;           /**< the saved Y, when the expression uses two variables */
+  struct usefunc_op_t *op; /**< the compiled expression, or NULL when it needs eval() */
+  int count;              /**< number of compiled operations */
+} usefunc_t;
+
+/**
+ * @ingroup par
+ *
+ * prepares a user's expression for repeated evaluation. X (and Y) are saved
+ * once and the expression is compiled when it is purely numeric.
+ *
+ * @note the keyword USE
+ *
+ * @param uf the state
+ * @param ip the expression's address
+ * @param vars the number of variables (1 = X, 2 = X and Y)
+ */
+void exec_usefunc_begin(usefunc_t *uf, bcip_t ip, int vars);
+
+/**
+ * @ingroup par
+ *
+ * evaluates the expression for the given X (and Y).
+ * the result will be stored in 'r'.
+ *
+ * @param uf the state
+ * @param x the value of X
+ * @param y the value of Y
+ * @param r the result
+ */
+void exec_usefunc_call(usefunc_t *uf, var_num_t x, var_num_t y, var_t *r);
+
+/**
+ * @ingroup par
+ *
+ * evaluates the expression for the given X (and Y)
+ *
+ * @param uf the state
+ * @param x the value of X
+ * @param y the value of Y
+ * @return the result as a number
+ */
+var_num_t exec_usefunc_num(usefunc_t *uf, var_num_t x, var_num_t y);
+
+/**
+ * @ingroup par
+ *
+ * evaluates the expression for each of the X values
+ *
+ * @param uf the state
+ * @param x the X values
+ * @param y the results
+ * @param count the number of values
+ */
+void exec_usefunc_vec(usefunc_t *uf, const var_num_t *x, var_num_t *y, int count);
+
+/**
+ * @ingroup par
+ *
+ * restores X (and Y) and releases the compiled expression
+ *
+ * @param uf the state
+ */
+void exec_usefunc_end(usefunc_t *uf);
+
 /**
  * @ingroup par
  *
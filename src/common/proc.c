@@ -66,6 +66,476 @@ void exec_usefunc2(var_t *var1, var_t *var2, bcip_t ip) {
   v_detach(old_y);
 }
 
+/*
+ * a numeric USE expression is compiled to a list of operations on a number
+ * register and a small stack, mirroring the eval() byte-code (see ceval.c).
+ * anything else (strings, arrays, UDFs, comparisons, ...) is left to eval()
+ */
+#define USEFUNC_STACK 32
+#define USEFUNC_PARALLEL 65536
+#define USEFUNC_MAX_THREADS 8
+
+enum usefunc_code {
+  UF_NUM,   // R = n
+  UF_X,     // R = X
+  UF_Y,     // R = Y
+  UF_VAR,   // R = variable
+  UF_PUSH,  // push R
+  UF_ADD,   // R = pop + R
+  UF_SUB,   // R = pop - R
+  UF_MUL,   // R = pop * R
+  UF_DIV,   // R = pop / R
+  UF_POW,   // R = pop ^ R
+  UF_NEG,   // R = -R
+  UF_FUNC   // R = func(R)
+};
+
+typedef struct usefunc_op_t {
+  byte code;
+  union {
+    var_num_t n;
+    var_t *var;
+    long fcode;
+  } arg;
+} usefunc_op_t;
+
+/*
+ * built-in functions of one number which have no side effects
+ */
+static int usefunc_is_math(long fcode) {
+  switch (fcode) {
+  case kwCOS:
+  case kwSIN:
+  case kwTAN:
+  case kwCOSH:
+  case kwSINH:
+  case kwTANH:
+  case kwACOS:
+  case kwASIN:
+  case kwATAN:
+  case kwACOSH:
+  case kwASINH:
+  case kwATANH:
+  case kwSEC:
+  case kwSECH:
+  case kwASEC:
+  case kwASECH:
+  case kwCSC:
+  case kwCSCH:
+  case kwACSC:
+  case kwACSCH:
+  case kwCOT:
+  case kwCOTH:
+  case kwACOT:
+  case kwACOTH:
+  case kwSQR:
+  case kwABS:
+  case kwEXP:
+  case kwLOG:
+  case kwLOG10:
+  case kwFIX:
+  case kwINT:
+  case kwDEG:
+  case kwRAD:
+  case kwFLOOR:
+  case kwCEIL:
+  case kwFRAC:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static int usefunc_add(usefunc_t *uf, int *size, byte code) {
+  if (uf->count == *size) {
+    *size = *size ? *size * 2 : 16;
+    usefunc_op_t *op = realloc(uf->op, *size * sizeof(usefunc_op_t));
+    if (op == NULL) {
+      return 0;
+    }
+    uf->op = op;
+  }
+  uf->op[uf->count++].code = code;
+  return 1;
+}
+
+/*
+ * compiles the expression at uf->ip, returns 0 when it needs eval()
+ */
+static int usefunc_compile(usefunc_t *uf) {
+  long calls[USEFUNC_STACK];
+  bcip_t ip = uf->ip;
+  var_int_t i;
+  var_num_t n;
+  bcip_t addr;
+  int size = 0;
+  int level = 0;
+  int sp = 0;
+  int numeric = 0;
+
+  calls[0] = 0;
+  for (;;) {
+    byte code = prog_source[ip];
+    switch (code) {
+    case kwTYPE_INT:
+      memcpy(&i, prog_source + ip + 1, OS_INTSZ);
+      ip += 1 + OS_INTSZ;
+      if (!usefunc_add(uf, &size, UF_NUM)) {
+        return 0;
+      }
+      uf->op[uf->count - 1].arg.n = i;
+      break;
+
+    case kwTYPE_NUM:
+      memcpy(&n, prog_source + ip + 1, OS_REALSZ);
+      ip += 1 + OS_REALSZ;
+      if (!usefunc_add(uf, &size, UF_NUM)) {
+        return 0;
+      }
+      uf->op[uf->count - 1].arg.n = n;
+      numeric = 1;
+      break;
+
+    case kwTYPE_VAR:
+      memcpy(&addr, prog_source + ip + 1, ADDRSZ);
+      ip += 1 + ADDRSZ;
+      if (prog_source[ip] == kwTYPE_LEVEL_BEGIN || prog_source[ip] == kwTYPE_UDS_EL) {
+        return 0;
+      }
+      if (addr == SYSVAR_X) {
+        code = UF_X;
+        numeric = 1;
+      } else if (addr == SYSVAR_Y && uf->old_y != NULL) {
+        code = UF_Y;
+        numeric = 1;
+      } else if (tvar[addr]->type == V_INT || tvar[addr]->type == V_NUM) {
+        // the value is read for each point, the type is checked again then
+        code = UF_VAR;
+        numeric |= (tvar[addr]->type == V_NUM);
+      } else {
+        return 0;
+      }
+      if (!usefunc_add(uf, &size, code)) {
+        return 0;
+      }
+      uf->op[uf->count - 1].arg.var = tvar[addr];
+      break;
+
+    case kwTYPE_EVPRIM:
+    case kwTYPE_EVPUSH:
+      // the operand and the operator follow, see eval_prim()
+      ip++;
+      if (++sp == USEFUNC_STACK || !usefunc_add(uf, &size, UF_PUSH)) {
+        return 0;
+      }
+      break;
+
+    case kwTYPE_EVPOP:
+      // the operator which follows pops the left side
+      ip++;
+      break;
+
+    case kwTYPE_ADDOPR:
+    case kwTYPE_MULOPR:
+    case kwTYPE_POWOPR:
+      switch (prog_source[ip + 1]) {
+      case '+':
+        code = UF_ADD;
+        break;
+      case '-':
+        code = UF_SUB;
+        break;
+      case '*':
+        code = UF_MUL;
+        break;
+      case '/':
+        code = UF_DIV;
+        break;
+      case '^':
+        code = UF_POW;
+        break;
+      default:
+        return 0;
+      }
+      ip += 2;
+      if (--sp < 0 || !usefunc_add(uf, &size, code)) {
+        return 0;
+      }
+      break;
+
+    case kwTYPE_UNROPR:
+      if (prog_source[ip + 1] == '-') {
+        if (!usefunc_add(uf, &size, UF_NEG)) {
+          return 0;
+        }
+      } else if (prog_source[ip + 1] != '+') {
+        return 0;
+      }
+      ip += 2;
+      break;
+
+    case kwTYPE_CALLF:
+      memcpy(&addr, prog_source + ip + 1, ADDRSZ);
+      ip += 1 + ADDRSZ;
+      if (!usefunc_is_math(addr) || prog_source[ip] != kwTYPE_LEVEL_BEGIN ||
+          level + 1 == USEFUNC_STACK) {
+        return 0;
+      }
+      // applied at the closing parenthesis
+      ip++;
+      calls[++level] = addr;
+      numeric = 1;
+      break;
+
+    case kwTYPE_LEVEL_BEGIN:
+      ip++;
+      if (level + 1 == USEFUNC_STACK) {
+        return 0;
+      }
+      calls[++level] = 0;
+      break;
+
+    case kwTYPE_LEVEL_END:
+      if (level == 0) {
+        return sp == 0 && numeric;
+      }
+      ip++;
+      if (calls[level]) {
+        if (!usefunc_add(uf, &size, UF_FUNC)) {
+          return 0;
+        }
+        uf->op[uf->count - 1].arg.fcode = calls[level];
+      }
+      level--;
+      break;
+
+    default:
+      if (level == 0 &&
+          (code == kwTYPE_LINE ||
+           code == kwTYPE_SEP ||
+           code == kwTO ||
+           code == kwTHEN ||
+           code == kwSTEP ||
+           kw_check_evexit(code))) {
+        return sp == 0 && numeric;
+      }
+      return 0;
+    }
+  }
+}
+
+/*
+ * runs the compiled expression, returns 0 when the point needs eval(),
+ * for example to report a division by zero
+ */
+static int usefunc_run(const usefunc_t *uf, var_num_t x, var_num_t y, var_num_t *result) {
+  var_num_t stack[USEFUNC_STACK];
+  var_num_t r = 0;
+  var_t arg;
+  int sp = 0;
+
+  for (int i = 0; i < uf->count; i++) {
+    const usefunc_op_t *op = &uf->op[i];
+    switch (op->code) {
+    case UF_NUM:
+      r = op->arg.n;
+      break;
+    case UF_X:
+      r = x;
+      break;
+    case UF_Y:
+      r = y;
+      break;
+    case UF_VAR:
+      if (op->arg.var->type == V_NUM) {
+        r = op->arg.var->v.n;
+      } else if (op->arg.var->type == V_INT) {
+        r = op->arg.var->v.i;
+      } else {
+        return 0;
+      }
+      break;
+    case UF_PUSH:
+      stack[sp++] = r;
+      break;
+    case UF_ADD:
+      r = stack[--sp] + r;
+      break;
+    case UF_SUB:
+      r = stack[--sp] - r;
+      break;
+    case UF_MUL:
+      r = stack[--sp] * r;
+      break;
+    case UF_DIV:
+      if (r == 0) {
+        return 0;
+      }
+      r = stack[--sp] / r;
+      break;
+    case UF_POW:
+      r = pow(stack[--sp], r);
+      break;
+    case UF_NEG:
+      r = -r;
+      break;
+    case UF_FUNC:
+      arg.type = V_NUM;
+      arg.v.n = r;
+      r = cmd_math1(op->arg.fcode, &arg);
+      break;
+    }
+  }
+  *result = r;
+  return 1;
+}
+
+void exec_usefunc_begin(usefunc_t *uf, bcip_t ip, int vars) {
+  uf->ip = ip;
+  uf->old_x = v_clone(tvar[SYSVAR_X]);
+  uf->old_y = vars > 1 ? v_clone(tvar[SYSVAR_Y]) : NULL;
+  uf->op = NULL;
+  uf->count = 0;
+  if (!usefunc_compile(uf)) {
+    free(uf->op);
+    uf->op = NULL;
+    uf->count = 0;
+  }
+}
+
+/*
+ * evaluates the expression with the interpreter
+ */
+static void usefunc_eval(usefunc_t *uf, var_num_t x, var_num_t y, var_t *r) {
+  v_setreal(tvar[SYSVAR_X], x);
+  if (uf->old_y != NULL) {
+    v_setreal(tvar[SYSVAR_Y], y);
+  }
+  v_free(r);
+  code_jump(uf->ip);
+  eval(r);
+}
+
+void exec_usefunc_call(usefunc_t *uf, var_num_t x, var_num_t y, var_t *r) {
+  var_num_t n;
+  if (uf->op != NULL && usefunc_run(uf, x, y, &n)) {
+    v_setreal(r, n);
+  } else {
+    usefunc_eval(uf, x, y, r);
+  }
+}
+
+var_num_t exec_usefunc_num(usefunc_t *uf, var_num_t x, var_num_t y) {
+  var_num_t n;
+  if (uf->op == NULL || !usefunc_run(uf, x, y, &n)) {
+    var_t r;
+    v_init(&r);
+    usefunc_eval(uf, x, y, &r);
+    n = prog_error ? 0 : v_getval(&r);
+    v_free(&r);
+  }
+  return n;
+}
+
+static void usefunc_vec(usefunc_t *uf, const var_num_t *x, var_num_t *y, int count) {
+  for (int i = 0; i < count && !prog_error; i++) {
+    y[i] = exec_usefunc_num(uf, x[i], 0);
+  }
+}
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct usefunc_task_t {
+  const usefunc_t *uf;
+  const var_num_t *x;
+  var_num_t *y;
+  int count;
+  int done;
+} usefunc_task_t;
+
+/**
+ * runs the compiled expression over the range, stopping at the
+ * first point which needs eval()
+ */
+static void *usefunc_thread(void *arg) {
+  usefunc_task_t *task = (usefunc_task_t *)arg;
+  while (task->done < task->count &&
+         usefunc_run(task->uf, task->x[task->done], 0, &task->y[task->done])) {
+    task->done++;
+  }
+  return NULL;
+}
+
+/**
+ * shares the points between the available processors. points which need
+ * eval() are completed afterwards in the interpreter's thread
+ */
+static int usefunc_parallel(usefunc_t *uf, const var_num_t *x, var_num_t *y, int count) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int parts = cpus < USEFUNC_MAX_THREADS ? cpus : USEFUNC_MAX_THREADS;
+  if (parts < 2) {
+    return 0;
+  }
+
+  usefunc_task_t task[USEFUNC_MAX_THREADS];
+  pthread_t thread[USEFUNC_MAX_THREADS];
+  int started[USEFUNC_MAX_THREADS];
+  for (int p = 0; p < parts; p++) {
+    int start = (int)((int64_t)count * p / parts);
+    int end = (int)((int64_t)count * (p + 1) / parts);
+    task[p].uf = uf;
+    task[p].x = x + start;
+    task[p].y = y + start;
+    task[p].count = end - start;
+    task[p].done = 0;
+  }
+  for (int p = 1; p < parts; p++) {
+    started[p] = pthread_create(&thread[p], NULL, usefunc_thread, &task[p]) == 0;
+    if (!started[p]) {
+      usefunc_thread(&task[p]);
+    }
+  }
+  usefunc_thread(&task[0]);
+  for (int p = 1; p < parts; p++) {
+    if (started[p]) {
+      pthread_join(thread[p], NULL);
+    }
+  }
+  for (int p = 0; p < parts && !prog_error; p++) {
+    usefunc_task_t *t = &task[p];
+    usefunc_vec(uf, t->x + t->done, t->y + t->done, t->count - t->done);
+  }
+  return 1;
+}
+#endif
+
+void exec_usefunc_vec(usefunc_t *uf, const var_num_t *x, var_num_t *y, int count) {
+  int done = 0;
+#if defined(HAVE_PTHREAD)
+  if (uf->op != NULL && count >= USEFUNC_PARALLEL) {
+    done = usefunc_parallel(uf, x, y, count);
+  }
+#endif
+  if (!done) {
+    usefunc_vec(uf, x, y, count);
+  }
+}
+
+void exec_usefunc_end(usefunc_t *uf) {
+  v_set(tvar[SYSVAR_X], uf->old_x);
+  v_free(uf->old_x);
+  v_detach(uf->old_x);
+  if (uf->old_y != NULL) {
+    v_set(tvar[SYSVAR_Y], uf->old_y);
+    v_free(uf->old_y);
+    v_detach(uf->old_y);
+  }
+  free(uf->op);
+  uf->op = NULL;
+}
+
 void pv_write_str(char *str, var_t *vp) {
   vp->v.p.length += strlen(str);
   if (vp->v.p.ptr == NULL) {
@@ -203,6 +673,9 @@ void par_skip() {
     case kwTYPE_VAR:           // [addr|id]
       prog_ip += ADDRSZ + 1;
       break;
+    case kwTYPE_UDS_EL:        // [4B-hash]
+      prog_ip += OS_HASHSZ + 1;
+      break;
     case kwTYPE_CALLF:
       prog_ip += CODESZ + 1;
       break;
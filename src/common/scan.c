@@ -235,6 +235,150 @@ int comp_is_external_func(const char *name) {
   return -1;
 }
 
+typedef const char *(*comp_name_func)(bid_t id);
+
+const char *comp_var_name(bid_t id) {
+  return comp_vartable[id].name;
+}
+
+const char *comp_udp_name(bid_t id) {
+  return comp_udptable[id].name;
+}
+
+const char *comp_label_name(bid_t id) {
+  return comp_labtable.elem[id]->name;
+}
+
+const char *comp_keyword_name(bid_t id) {
+  return keyword_table[id].name;
+}
+
+const char *comp_func_name(bid_t id) {
+  return func_table[id].name;
+}
+
+const char *comp_proc_name(bid_t id) {
+  return proc_table[id].name;
+}
+
+const char *comp_spopr_name(bid_t id) {
+  return spopr_table[id].name;
+}
+
+const char *comp_opr_name(bid_t id) {
+  return opr_table[id].name;
+}
+
+// the static keyword tables are indexed once
+static comp_name_index_t keyword_index;
+static comp_name_index_t func_index;
+static comp_name_index_t proc_index;
+static comp_name_index_t spopr_index;
+static comp_name_index_t opr_index;
+
+/*
+ * FNV-1a hash of the name
+ */
+uint32_t comp_hash_name(const char *name) {
+  uint32_t hash = 2166136261u;
+  while (*name) {
+    hash = (hash ^ (byte)*name) * 16777619u;
+    name++;
+  }
+  return hash;
+}
+
+void comp_index_create(comp_name_index_t *index) {
+  index->size = 0;
+  index->count = 0;
+  index->hash = NULL;
+  index->id = NULL;
+}
+
+void comp_index_destroy(comp_name_index_t *index) {
+  free(index->hash);
+  free(index->id);
+  comp_index_create(index);
+}
+
+/*
+ * stores the id in the first free slot for the hash
+ */
+void comp_index_insert(comp_name_index_t *index, uint32_t hash, bid_t id) {
+  uint32_t mask = index->size - 1;
+  uint32_t i = hash & mask;
+  while (index->id[i] != -1) {
+    i = (i + 1) & mask;
+  }
+  index->hash[i] = hash;
+  index->id[i] = id;
+  index->count++;
+}
+
+/*
+ * doubles the number of slots
+ */
+void comp_index_grow(comp_name_index_t *index) {
+  uint32_t *hash = index->hash;
+  bid_t *id = index->id;
+  uint32_t size = index->size;
+
+  index->size = size ? size * 2 : GROWSIZE;
+  index->count = 0;
+  index->hash = malloc(index->size * sizeof(uint32_t));
+  index->id = malloc(index->size * sizeof(bid_t));
+  for (uint32_t i = 0; i < index->size; i++) {
+    index->id[i] = -1;
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    if (id[i] != -1) {
+      comp_index_insert(index, hash[i], id[i]);
+    }
+  }
+  free(hash);
+  free(id);
+}
+
+/*
+ * returns the table id of the name or -1
+ */
+bid_t comp_index_find(comp_name_index_t *index, const char *name, comp_name_func name_of) {
+  if (index->size) {
+    uint32_t hash = comp_hash_name(name);
+    uint32_t mask = index->size - 1;
+    for (uint32_t i = hash & mask; index->id[i] != -1; i = (i + 1) & mask) {
+      if (index->hash[i] == hash && strcmp(name_of(index->id[i]), name) == 0) {
+        return index->id[i];
+      }
+    }
+  }
+  return -1;
+}
+
+/*
+ * adds the table id of the name. like the linear search it replaces, the
+ * first entry wins when a name is added more than once
+ */
+void comp_index_add(comp_name_index_t *index, const char *name, bid_t id, comp_name_func name_of) {
+  if (comp_index_find(index, name, name_of) == -1) {
+    if ((index->count + 1) * 2 > index->size) {
+      comp_index_grow(index);
+    }
+    comp_index_insert(index, comp_hash_name(name), id);
+  }
+}
+
+/*
+ * builds the index of a static keyword table
+ */
+void comp_index_table(comp_name_index_t *index, comp_name_func name_of) {
+  if (!index->size) {
+    for (bid_t i = 0; name_of(i)[0] != '\0'; i++) {
+      comp_index_add(index, name_of(i), i, name_of);
+    }
+  }
+}
+
 /*
  * Notes:
  *  block_level = the depth of nested block
@@ -280,17 +424,11 @@ char *comp_prepare_name(char *dest, const char *source, int size) {
  * returns the ID of the label. If there is no one, then it creates one
  */
 bid_t comp_label_getID(const char *label_name) {
-  bid_t idx = -1, i;
+  bid_t idx;
   char name[SB_KEYWORD_SIZE + 1];
 
   comp_prepare_name(name, label_name, SB_KEYWORD_SIZE);
-
-  for (i = 0; i < comp_labtable.count; i++) {
-    if (strcmp(comp_labtable.elem[i]->name, name) == 0) {
-      idx = i;
-      break;
-    }
-  }
+  idx = comp_index_find(&comp_labindex, name, comp_label_name);
 
   if (idx == -1) {
     if (opt_verbose) {
@@ -313,6 +451,7 @@ bid_t comp_label_getID(const char *label_name) {
     comp_labtable.elem[comp_labtable.count] = label;
     idx = comp_labtable.count;
     comp_labtable.count++;
+    comp_index_add(&comp_labindex, name, idx, comp_label_name);
   }
 
   return idx;
@@ -348,7 +487,7 @@ void comp_prepare_udp_name(char *dest, const char *basename) {
  * returns the ID of the UDP/UDF
  */
 bid_t comp_udp_id(const char *proc_name, int scan_tree) {
-  bid_t i;
+  bid_t i = -1;
   char *name = comp_bc_temp;
 
   if (scan_tree) {
@@ -371,11 +510,10 @@ bid_t comp_udp_id(const char *proc_name, int scan_tree) {
         strcpy(name, base);
       }
       // search on local
-      for (i = 0; i < comp_udpcount; i++) {
-        if (strcmp(comp_udptable[i].name, name) == 0) {
-          free(root);
-          return i;
-        }
+      i = comp_index_find(&comp_udpindex, name, comp_udp_name);
+      if (i != -1) {
+        free(root);
+        return i;
       }
     } while (len);
 
@@ -385,14 +523,10 @@ bid_t comp_udp_id(const char *proc_name, int scan_tree) {
     comp_prepare_udp_name(name, proc_name);
 
     // search on local
-    for (i = 0; i < comp_udpcount; i++) {
-      if (strcmp(comp_udptable[i].name, name) == 0) {
-        return i;
-      }
-    }
+    i = comp_index_find(&comp_udpindex, name, comp_udp_name);
   }
 
-  return -1;
+  return i;
 }
 
 /*
@@ -401,7 +535,7 @@ bid_t comp_udp_id(const char *proc_name, int scan_tree) {
  */
 bid_t comp_add_udp(const char *proc_name) {
   char *name = comp_bc_temp;
-  bid_t idx = -1, i;
+  bid_t idx;
   comp_prepare_udp_name(name, proc_name);
 
   /*
@@ -412,12 +546,7 @@ bid_t comp_add_udp(const char *proc_name) {
    */
 
   // search
-  for (i = 0; i < comp_udpcount; i++) {
-    if (strcmp(comp_udptable[i].name, name) == 0) {
-      idx = i;
-      break;
-    }
-  }
+  idx = comp_index_find(&comp_udpindex, name, comp_udp_name);
 
   if (idx == -1) {
     if (comp_udpcount >= comp_udpsize) {
@@ -439,6 +568,7 @@ bid_t comp_add_udp(const char *proc_name) {
       strcpy(comp_udptable[comp_udpcount].name, name);
       idx = comp_udpcount;
       comp_udpcount++;
+      comp_index_add(&comp_udpindex, name, idx, comp_udp_name);
     }
   }
 
@@ -629,6 +759,7 @@ int comp_create_var(const char *name) {
     comp_vartable[comp_varcount].local_proc_level = 0;
     idx = comp_varcount;
     comp_varcount++;
+    comp_index_add(&comp_varindex, name, idx, comp_var_name);
   }
   return idx;
 }
@@ -702,24 +833,16 @@ bid_t comp_var_getID(const char *var_name) {
   //
   strcpy(name, tmp);
 
-  for (i = 0; i < comp_varcount; i++) {
-    if (strcmp(comp_vartable[i].name, name) == 0) {
+  idx = comp_index_find(&comp_varindex, name, comp_var_name);
+  int len = strlen(name);
+  if (idx == -1 && len > 1 && name[len - 1] == '$') {
+    // system variables must be visible with or without '$' suffix
+    name[len - 1] = '\0';
+    i = comp_index_find(&comp_varindex, name, comp_var_name);
+    if (i != -1 && comp_vartable[i].dolar_sup) {
       idx = i;
-      break;
-    }
-
-    if (comp_vartable[i].dolar_sup) {
-      // system variables must be visible with or without '$' suffix
-      char *dollar_name = malloc(strlen(comp_vartable[i].name) + 2);
-      strcpy(dollar_name, comp_vartable[i].name);
-      strcat(dollar_name, "$");
-      if (strcmp(dollar_name, name) == 0) {
-        idx = i;
-        free(dollar_name);
-        break;
-      }
-      free(dollar_name);
     }
+    name[len - 1] = '$';
   }
 
   if (opt_autolocal) {
@@ -795,8 +918,7 @@ void comp_add_variable(bc_t *bc, const char *var_name) {
         len = strlen(dot + 1);
       }
 
-      bc_add_code(bc, kwTYPE_UDS_EL);
-      bc_add_strn(bc, dot + 1, len);
+      bc_add_field(bc, dot + 1, len);
 
       if (dot_end) {
         dot = dot_end;
@@ -853,10 +975,9 @@ int comp_is_keyword(const char *name) {
     dolar_sup++;
   }
 
-  for (i = 0; keyword_table[i].name[0] != '\0'; i++) {
-    if (strcmp(keyword_table[i].name, name) == 0) {
-      return keyword_table[i].code;
-    }
+  i = comp_index_find(&keyword_index, name, comp_keyword_name);
+  if (i != -1) {
+    return keyword_table[i].code;
   }
 
   if (dolar_sup) {
@@ -885,10 +1006,9 @@ bid_t comp_is_func(const char *name) {
     dolar_sup++;
   }
 
-  for (i = 0; func_table[i].name[0] != '\0'; i++) {
-    if (strcmp(func_table[i].name, name) == 0) {
-      return func_table[i].fcode;
-    }
+  i = comp_index_find(&func_index, name, comp_func_name);
+  if (i != -1) {
+    return func_table[i].fcode;
   }
 
   if (dolar_sup) {
@@ -904,13 +1024,8 @@ bid_t comp_is_func(const char *name) {
 bid_t comp_is_proc(const char *name) {
   bid_t i;
 
-  for (i = 0; proc_table[i].name[0] != '\0'; i++) {
-    if (strcmp(proc_table[i].name, name) == 0) {
-      return proc_table[i].pcode;
-    }
-  }
-
-  return -1;
+  i = comp_index_find(&proc_index, name, comp_proc_name);
+  return i != -1 ? proc_table[i].pcode : -1;
 }
 
 /*
@@ -919,13 +1034,8 @@ bid_t comp_is_proc(const char *name) {
 int comp_is_special_operator(const char *name) {
   int i;
 
-  for (i = 0; spopr_table[i].name[0] != '\0'; i++) {
-    if (strcmp(spopr_table[i].name, name) == 0) {
-      return spopr_table[i].code;
-    }
-  }
-
-  return -1;
+  i = comp_index_find(&spopr_index, name, comp_spopr_name);
+  return i != -1 ? spopr_table[i].code : -1;
 }
 
 /*
@@ -934,13 +1044,8 @@ int comp_is_special_operator(const char *name) {
 int comp_is_operator(const char *name) {
   int i;
 
-  for (i = 0; opr_table[i].name[0] != '\0'; i++) {
-    if (strcmp(opr_table[i].name, name) == 0) {
-      return ((opr_table[i].code << 8) | opr_table[i].opr);
-    }
-  }
-
-  return -1;
+  i = comp_index_find(&opr_index, name, comp_opr_name);
+  return i != -1 ? ((opr_table[i].code << 8) | opr_table[i].opr) : -1;
 }
 
 /*
@@ -1809,8 +1914,7 @@ char *comp_array_uds_field(char *p, bc_t *bc) {
     if (*p == 0 || (*p != '_' && !isalnum(*p))) {
       int len = (p - p_begin);
       if (len) {
-        bc_add_code(bc, kwTYPE_UDS_EL);
-        bc_add_strn(bc, p_begin, len);
+        bc_add_field(bc, p_begin, len);
       }
       if (*p == '.') {
         p_begin = p + 1;
@@ -2378,7 +2482,18 @@ void comp_text_line_for() {
             comp_add_variable(&comp_prog, comp_bc_name);
             *n = ' ';
             bc_add_code(&comp_prog, kwIN);
-            comp_expression(n + 4, 0);
+            char *expr = n + 4;
+            SKIP_SPACES(expr);
+            if (strncmp(expr, LCN_FILE, STRLEN(LCN_FILE)) == 0) {
+              // FOR X IN FILE(path), FILE is a keyword in this position
+              char *args = expr + STRLEN(LCN_FILE);
+              SKIP_SPACES(args);
+              if (*args == '(') {
+                bc_add_code(&comp_prog, kwFILE);
+                expr = args;
+              }
+            }
+            comp_expression(expr, 0);
           }
         }
       }
@@ -3027,6 +3142,9 @@ bcip_t comp_next_bc_cmd(bc_t *bc, bcip_t ip) {
   case kwTYPE_CALLP:           // [bid_t]
     ip += CODESZ;
     break;
+  case kwTYPE_UDS_EL:          // [4B-hash] followed by the name
+    ip += OS_HASHSZ;
+    break;
   case kwTYPE_CALLEXTF:
   case kwTYPE_CALLEXTP:        // [lib][index]
     ip += (ADDRSZ * 2);
@@ -3748,9 +3866,90 @@ bcip_t comp_optimise_line_goto(bcip_t ip) {
 }
 
 // use simpler LET where possible to avoid eval on the right term
+/*
+ * scans the terms of v = v + x [+ y ...] starting after the leading v, returning
+ * the position of the last kwTYPE_ADDOPR or 0 when the terms can't be added to v
+ * in place, ie when a term refers to v or calls user code. when patch is set,
+ * the kwTYPE_EVPOP ending each expression becomes a kwTYPE_EOC for eval()
+ */
+static bcip_t comp_append_terms(bcip_t ip, const byte *var, int patch) {
+  byte *p = comp_prog.ptr;
+  bcip_t result = 0;
+  while (p[ip] == kwTYPE_EVPRIM || p[ip] == kwTYPE_EVPUSH) {
+    if (p[ip++] == kwTYPE_EVPRIM) {
+      if (p[ip] == kwTYPE_VAR && memcmp(p + ip + 1, var, ADDRSZ) == 0) {
+        return 0;
+      }
+      ip = comp_next_bc_cmd(&comp_prog, ip);
+    } else {
+      int level = 0;
+      while (level || p[ip] != kwTYPE_EVPOP) {
+        switch (p[ip]) {
+        case kwTYPE_EVPUSH:
+          level++;
+          break;
+        case kwTYPE_EVPOP:
+          level--;
+          break;
+        case kwTYPE_VAR:
+          if (memcmp(p + ip + 1, var, ADDRSZ) == 0) {
+            return 0;
+          }
+          break;
+        case kwTYPE_CALL_UDF:
+        case kwTYPE_CALL_PTR:
+        case kwTYPE_CALLEXTF:
+        case kwTYPE_EOC:
+        case kwTYPE_LINE:
+          return 0;
+        default:
+          break;
+        }
+        ip = comp_next_bc_cmd(&comp_prog, ip);
+        if (ip >= comp_prog.count) {
+          return 0;
+        }
+      }
+      if (patch) {
+        p[ip] = kwTYPE_EOC;
+      }
+      ip++;
+    }
+    if (p[ip] != kwTYPE_ADDOPR || p[ip + 1] != '+') {
+      return 0;
+    }
+    result = ip;
+    ip += 2;
+  }
+  return (p[ip] == kwTYPE_EOC || p[ip] == kwTYPE_LINE) ? result : 0;
+}
+
+/*
+ * LET v = v + x [+ y ...] => LET_APPEND, strings are then built without copying v
+ */
+bcip_t comp_optimise_append(bcip_t ip) {
+  byte *p = comp_prog.ptr;
+  bcip_t ip_next = ip + 2 + ADDRSZ;
+  bcip_t result = 0;
+  if (p[ip_next] == kwTYPE_CMPOPR && p[ip_next + 1] == '=' &&
+      p[ip_next + 2] == kwTYPE_VAR &&
+      memcmp(p + ip_next + 3, p + ip + 2, ADDRSZ) == 0) {
+    ip_next += 3 + ADDRSZ;
+    if (comp_append_terms(ip_next, p + ip + 2, 0)) {
+      p[ip] = kwLET_APPEND;
+      result = comp_append_terms(ip_next, p + ip + 2, 1);
+    }
+  }
+  return result;
+}
+
 bcip_t comp_optimise_let(bcip_t ip) {
   bcip_t ip_next = ip + 1;
   if (comp_prog.ptr[ip_next] == kwTYPE_VAR) {
+    bcip_t append = comp_optimise_append(ip);
+    if (append) {
+      return append;
+    }
     ip_next += 1 + sizeof(bcip_t);
     while (ip_next < comp_prog.count && comp_prog.ptr[ip_next] != kwTYPE_EOC
            && comp_prog.ptr[ip_next] != kwTYPE_LINE) {
@@ -3826,6 +4025,15 @@ void comp_init() {
 
   comp_vartable = (comp_var_t *)malloc(GROWSIZE * sizeof(comp_var_t));
   comp_udptable = (comp_udp_t *)malloc(GROWSIZE * sizeof(comp_udp_t));
+  comp_index_create(&comp_varindex);
+  comp_index_create(&comp_udpindex);
+  comp_index_create(&comp_labindex);
+
+  comp_index_table(&keyword_index, comp_keyword_name);
+  comp_index_table(&func_index, comp_func_name);
+  comp_index_table(&proc_index, comp_proc_name);
+  comp_index_table(&spopr_index, comp_spopr_name);
+  comp_index_table(&opr_index, comp_opr_name);
 
   comp_labtable.count = 0;
   comp_labtable.size = 256;
@@ -3891,6 +4099,10 @@ void comp_close() {
   }
   free(comp_labtable.elem);
 
+  comp_index_destroy(&comp_varindex);
+  comp_index_destroy(&comp_udpindex);
+  comp_index_destroy(&comp_labindex);
+
   for (i = 0; i < comp_exptable.count; i++) {
     free(comp_exptable.elem[i]);
   }
@@ -4833,7 +5045,7 @@ byte_code comp_create_bin() {
   }
 
   memcpy(&hdr.sign, "SBEx", 4);
-  hdr.ver = 2;
+  hdr.ver = SB_BC_VER;
   hdr.sbver = SB_DWORD_VER;
 #if defined(CPU_BIGENDIAN)
   hdr.flags = 1;
@@ -182,6 +182,19 @@ typedef struct {
   comp_pass_node_t **elem;
 } comp_pass_node_table_t;
 
+/**
+ * @ingroup scan
+ * @typedef comp_name_index_t
+ *
+ * hash index for the name tables (variables, labels, procedures, keywords)
+ */
+typedef struct {
+  uint32_t size; /**< number of slots (power of 2) */
+  uint32_t count; /**< number of used slots */
+  uint32_t *hash; /**< name hash of each slot */
+  bid_t *id; /**< table index of each slot (-1 for empty) */
+} comp_name_index_t;
+
 #if !defined(SCAN_MODULE)       // actually static data
 extern struct keyword_s keyword_table[]; /**< basic keywords             @ingroup scan */
 extern struct opr_keyword_s opr_table[]; /**< operators table            @ingroup scan */
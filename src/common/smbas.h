@@ -19,6 +19,14 @@
 extern "C" {
 #endif
 
+/**
+ * @ingroup exec
+ *
+ * version of the byte-code format (bc_head_t::ver), changed when the byte-code
+ * of a statement changes between releases of SB
+ */
+#define SB_BC_VER 3
+
 /**
  * @ingroup exec
  *
@@ -175,6 +183,7 @@ EXTERN byte gsb_err_mod_perm; /**< whether a module was not permitted to run */
 #define comp_vartable       ctask->sbe.comp.vartable
 #define comp_varcount       ctask->sbe.comp.varcount
 #define comp_varsize        ctask->sbe.comp.varsize
+#define comp_varindex       ctask->sbe.comp.varindex
 #define comp_imptable       ctask->sbe.comp.imptable
 #define comp_impcount       ctask->sbe.comp.imptable.count
 #define comp_exptable       ctask->sbe.comp.exptable
@@ -183,6 +192,7 @@ EXTERN byte gsb_err_mod_perm; /**< whether a module was not permitted to run */
 #define comp_libcount       ctask->sbe.comp.libtable.count
 #define comp_labtable       ctask->sbe.comp.labtable
 #define comp_labcount       ctask->sbe.comp.labtable.count
+#define comp_labindex       ctask->sbe.comp.labindex
 #define comp_bc_sec         ctask->sbe.comp.bc_sec
 #define comp_block_level    ctask->sbe.comp.block_level
 #define comp_block_id       ctask->sbe.comp.block_id
@@ -197,6 +207,7 @@ EXTERN byte gsb_err_mod_perm; /**< whether a module was not permitted to run */
 #define comp_udptable       ctask->sbe.comp.udptable
 #define comp_udpcount       ctask->sbe.comp.udpcount
 #define comp_udpsize        ctask->sbe.comp.udpsize
+#define comp_udpindex       ctask->sbe.comp.udpindex
 #define comp_use_global_vartable    ctask->sbe.comp.use_global_vartable
 #define comp_stack          ctask->sbe.comp.stack
 #define comp_sp             ctask->sbe.comp.stack.count
@@ -94,51 +94,90 @@ int strcaselessn(const char *s1, int s1n, const char *s2, int s2n) {
   return result;
 }
 
+/**
+ * returns the first occurrence of what between s and end ignoring case
+ */
+static const char *str_casefind(const char *s, const char *end, const char *what, size_t lwhat) {
+  int first = tolower((unsigned char)what[0]);
+  for (const char *p = s; p + lwhat <= end; p++) {
+    if (tolower((unsigned char)*p) == first && strncasecmp(p, what, lwhat) == 0) {
+      return p;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * returns the last occurrence of the needle in the first len bytes of s,
+ * scanning backward and skipping with the Horspool shift
+ */
+const char *str_rfind(const char *s, size_t len, const char *needle, size_t needle_len) {
+  const unsigned char *h = (const unsigned char *)s;
+  const unsigned char *n = (const unsigned char *)needle;
+  size_t skip[256];
+
+  if (needle_len == 0) {
+    return s + len;
+  } else if (needle_len > len) {
+    return NULL;
+  }
+
+  // the distance from the start of the needle to the nearest later
+  // occurrence of each byte
+  for (int i = 0; i < 256; i++) {
+    skip[i] = needle_len;
+  }
+  for (size_t i = needle_len - 1; i > 0; i--) {
+    skip[n[i]] = i;
+  }
+
+  size_t pos = len - needle_len;
+  for (;;) {
+    if (h[pos] == n[0] && memcmp(h + pos + 1, n + 1, needle_len - 1) == 0) {
+      return s + pos;
+    }
+    size_t shift = skip[h[pos]];
+    if (pos < shift) {
+      break;
+    }
+    pos -= shift;
+  }
+  return NULL;
+}
+
 /**
  * transdup
  */
 char *transdup(const char *src, const char *what, const char *with, int ignore_case) {
-  int lwhat = strlen(what);
-  int lwith = strlen(with);
-  int size = BUF_SIZE;
-  char *p = (char *)src;
+  size_t lwhat = strlen(what);
+  size_t lwith = strlen(with);
+  size_t size = strlen(src) + 1;
+  size_t len = 0;
+  const char *p = src;
+  const char *end = src + size - 1;
   char *dest = malloc(size);
-  char *d = dest;
-
-  *d = '\0';
 
-  while (*p) {
-    int eq;
-    if (ignore_case) {
-      eq = strncasecmp(p, what, lwhat);
-    }
-    else {
-      eq = strncmp(p, what, lwhat);
+  while (lwhat) {
+    const char *next = ignore_case ? str_casefind(p, end, what, lwhat) :
+                       (const char *)memmem(p, end - p, what, lwhat);
+    if (next == NULL) {
+      break;
     }
-    if (eq == 0) {
-      if ((d - dest) + lwith >= size - 1) {
-        int len = d - dest;
-        size += BUF_SIZE;
-        dest = realloc(dest, size);
-        d = dest + len;
-      }
-      memcpy(d, with, lwith);
-      d += lwith;
-      p += (lwhat - 1);
-    } else {
-      if ((d - dest) + 1 >= size - 1) {
-        int len = d - dest;
-        size += BUF_SIZE;
-        dest = realloc(dest, size);
-        d = dest + len;
-      }
-      *d = *p;
-      d++;
+    size_t n = next - p;
+    size_t required = len + n + lwith + (end - next - lwhat) + 1;
+    if (required > size) {
+      size = required * 2;
+      dest = realloc(dest, size);
     }
-    p++;
+    memcpy(dest + len, p, n);
+    len += n;
+    memcpy(dest + len, with, lwith);
+    len += lwith;
+    p = next + lwhat;
   }
 
-  *d = '\0';
+  memcpy(dest + len, p, end - p);
+  dest[len + (end - p)] = '\0';
   return dest;
 }
 
@@ -154,7 +193,24 @@ char *q_strstr(const char *s1, const char *s2, const char *pairs) {
   l2 = strlen(s2);
   wait_q = open_q = level_q = 0;
 
+  // the characters which may start a match or a pair
+  char stop[32];
+  size_t pairs_len = strlen(pairs);
+  if (l2 && pairs_len < sizeof(stop) - 1) {
+    memcpy(stop, pairs, pairs_len);
+    stop[pairs_len] = s2[0];
+    stop[pairs_len + 1] = '\0';
+  } else {
+    stop[0] = '\0';
+  }
+
   while (*p) {
+    if (wait_q == 0 && stop[0]) {
+      p += strcspn(p, stop);
+      if (!*p) {
+        break;
+      }
+    }
     if (*p == wait_q) {         // i am waiting that. level down
       level_q--;
       if (level_q <= 0) {       // level = 0
@@ -184,7 +240,7 @@ char *q_strstr(const char *s1, const char *s2, const char *pairs) {
         }
       }
     } else if (wait_q == 0) {     // it is a regular character
-      if (strncmp(p, s2, l2) == 0) {
+      if (*p == *s2 && strncmp(p, s2, l2) == 0) {
         return p;
       }
     }
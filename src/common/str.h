@@ -266,6 +266,19 @@ int strcaselessn(const char *s1, int s1n, const char *s2, int s2n);
  */
 char *q_strstr(const char *s1, const char *s2, const char *pairs);
 
+/**
+ * @ingroup str
+ *
+ * locate the last occurrence of the 'needle' in the first 'len' bytes of 's'
+ *
+ * @param s the text
+ * @param len the length of the text
+ * @param needle the substring
+ * @param needle_len the length of the substring
+ * @return a pointer to the last occurrence in 's'; otherwise NULL
+ */
+const char *str_rfind(const char *s, size_t len, const char *needle, size_t needle_len);
+
 /**
  * @ingroup str
  *
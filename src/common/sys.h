@@ -50,6 +50,7 @@ extern "C" {
 #define OS_PATHNAME_SIZE    1024
 #define OS_FILENAME_SIZE    256
 #define OS_FILEHANDLES      256
+#define OS_HIDDEN_FILEHANDLES 32
 
 #if defined(_Win32)
  #define SB_VERSYS "Win"
@@ -124,6 +125,7 @@ typedef uint32_t bcip_t;
 #define OS_ADDRSZ   4   // size of address pointer (always 4 for 32b addresses)
 #define OS_CODESZ   4   // size of buildin func/proc ptrs (always 4 for 32b mode)
 #define OS_STRLEN   4   // size of strings
+#define OS_HASHSZ   4   // size of the structure element name hash
 
 #define ADDRSZ      OS_ADDRSZ
 #define CODESZ      OS_CODESZ
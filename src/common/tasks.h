@@ -105,14 +105,17 @@ typedef struct {
   comp_var_t *vartable;
   bid_t varcount;
   bid_t varsize;
+  comp_name_index_t varindex;
 
   // label table
   comp_label_table_t labtable;
+  comp_name_index_t labindex;
 
   // user defined proc/func table
   comp_udp_t *udptable;
   bid_t udpcount;
   bid_t udpsize;
+  comp_name_index_t udpindex;
 
   // pass2 stack
   comp_pass_node_table_t stack;
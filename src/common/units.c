@@ -91,6 +91,27 @@ int find_unit(const char *name, char *file) {
   return 0;
 }
 
+/**
+ * returns true when the unit's binary has the byte-code format of this version
+ */
+static int unit_is_current(const char *unitname) {
+  unit_file_t uft;
+  bc_head_t hdr;
+  int result = 0;
+  int h = open(unitname, O_RDONLY | O_BINARY);
+  if (h != -1) {
+    if (read(h, &uft, sizeof(unit_file_t)) == sizeof(unit_file_t) &&
+        uft.version == SB_DWORD_VER &&
+        lseek(h, sizeof(unit_sym_t) * uft.sym_count, SEEK_CUR) != -1 &&
+        read(h, &hdr, sizeof(bc_head_t)) == sizeof(bc_head_t) &&
+        hdr.ver == SB_BC_VER) {
+      result = 1;
+    }
+    close(h);
+  }
+  return result;
+}
+
 /**
  * open unit
  *
@@ -129,6 +150,9 @@ int open_unit(const char *file, const char *alias) {
   if ((ut = sys_filetime(unitname)) == 0L) {
     // binary not found - compile
     comp_rq = 1;
+  } else if (!unit_is_current(unitname)) {
+    // binary built by another version - compile
+    comp_rq = 1;
   } else {
     if ((st = sys_filetime(bas_file))) {
       // source found
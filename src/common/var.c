@@ -10,6 +10,7 @@
 #include "common/sys.h"
 #include "common/sberr.h"
 #include "common/plugins.h"
+#include "common/messages.h"
 
 #define INT_STR_LEN 64
 
@@ -19,20 +20,78 @@
 #define VAR_POOL_SIZE 8192
 #endif
 
-var_t var_pool[VAR_POOL_SIZE];
+/**
+ * The pool grows by adding slabs of variables which are released
+ * once all of the pooled variables have been returned
+ */
+typedef struct var_slab_s {
+  struct var_slab_s *next;
+  var_t vars[VAR_POOL_SIZE];
+} var_slab_t;
+
+typedef struct var_pool_stats_s {
+  uint64_t allocs;
+  uint32_t slabs;
+  uint32_t in_use;
+  uint32_t peak;
+} var_pool_stats_t;
+
+var_slab_t var_pool;
 var_t *var_pool_head;
+var_pool_stats_t var_pool_stats;
 
-void v_init_pool() {
+/*
+ * adds the slab variables onto the free-list
+ */
+static void v_pool_add_slab(var_slab_t *slab) {
   for (uint32_t i = 0; i < VAR_POOL_SIZE; i++) {
-    v_init(&var_pool[i]);
-    var_pool[i].pooled = 1;
-    if (i + 1 < VAR_POOL_SIZE) {
-      var_pool[i].v.pool_next = &var_pool[i + 1];
-    } else {
-      var_pool[i].v.pool_next = NULL;
+    v_init(&slab->vars[i]);
+    slab->vars[i].pooled = 1;
+    slab->vars[i].v.pool_next = (i + 1 < VAR_POOL_SIZE) ? &slab->vars[i + 1] : var_pool_head;
+  }
+  var_pool_head = &slab->vars[0];
+  var_pool_stats.slabs++;
+}
+
+/*
+ * releases the slabs added after the initial pool
+ */
+static void v_pool_free_slabs() {
+  var_slab_t *slab = var_pool.next;
+  while (slab != NULL) {
+    var_slab_t *next = slab->next;
+    free(slab);
+    slab = next;
+  }
+  var_pool.next = NULL;
+}
+
+void v_init_pool() {
+  if (var_pool_stats.in_use == 0) {
+    // no pooled variable is live, so the added slabs can be released
+    v_pool_free_slabs();
+    memset(&var_pool_stats, 0, sizeof(var_pool_stats));
+    var_pool_head = NULL;
+    v_pool_add_slab(&var_pool);
+  } else {
+    // keep the slabs holding the live variables
+    var_pool_stats.allocs = 0;
+    var_pool_stats.peak = var_pool_stats.in_use;
+  }
+}
+
+void v_close_pool() {
+  if (opt_verbose) {
+    log_printf(MSG_VAR_POOL, (unsigned long long)var_pool_stats.allocs,
+               var_pool_stats.slabs, var_pool_stats.slabs * VAR_POOL_SIZE,
+               var_pool_stats.in_use, var_pool_stats.peak);
+    if (var_pool_stats.in_use != 0) {
+      log_printf(MSG_VAR_POOL_LEAK, var_pool_stats.in_use);
     }
   }
-  var_pool_head = &var_pool[0];
+  // every task is closed, any variable still in use has leaked
+  var_pool_stats.in_use = 0;
+  v_init_pool();
 }
 
 /*
@@ -40,11 +99,24 @@ void v_init_pool() {
  */
 var_t *v_new() {
   var_t *result = var_pool_head;
+  var_pool_stats.allocs++;
+  if (result == NULL) {
+    // pool exhausted
+    var_slab_t *slab = (var_slab_t *)malloc(sizeof(var_slab_t));
+    if (slab != NULL) {
+      slab->next = var_pool.next;
+      var_pool.next = slab;
+      v_pool_add_slab(slab);
+      result = var_pool_head;
+    }
+  }
   if (result != NULL) {
     // remove an item from the free-list
     var_pool_head = result->v.pool_next;
+    if (++var_pool_stats.in_use > var_pool_stats.peak) {
+      var_pool_stats.peak = var_pool_stats.in_use;
+    }
   } else {
-    // pool exhausted
     result = (var_t *)malloc(sizeof(var_t));
     result->pooled = 0;
   }
@@ -56,43 +128,44 @@ void v_pool_free(var_t *var) {
   // insert back into the free list
   var->v.pool_next = var_pool_head;
   var_pool_head = var;
+  var_pool_stats.in_use--;
 }
 
 uint32_t v_get_capacity(uint32_t size) {
   return size + (size / 2) + 1;
 }
 
-// allocate capacity in the array container
-void v_alloc_capacity(var_t *var, uint32_t size) {
-  uint32_t capacity = v_get_capacity(size);
-  v_capacity(var) = capacity;
-  v_asize(var) = size;
-  v_data(var) = (var_t *)malloc(sizeof(var_t) * capacity);
-  if (!v_data(var)) {
+// allocate the bounds and the array container. all bits zero is an initialised non-pooled V_INT
+static void v_alloc_array(var_t *var, uint32_t size, uint32_t capacity) {
+  var_bounds_t *bounds = (var_bounds_t *)calloc(1, sizeof(var_bounds_t) + sizeof(var_t) * capacity);
+  if (!bounds) {
     err_memory();
-  } else {
-    for (uint32_t i = 0; i < capacity; i++) {
-      var_t *e = v_elem(var, i);
-      e->pooled = 0;
-      v_init(e);
-    }
+    size = capacity = 0;
+    bounds = (var_bounds_t *)calloc(1, sizeof(var_bounds_t));
   }
+  v_capacity(var) = capacity;
+  v_asize(var) = size;
+  v_data(var) = (var_t *)(bounds + 1);
+}
+
+// allocate capacity in the array container
+void v_alloc_capacity(var_t *var, uint32_t size) {
+  v_alloc_array(var, size, v_get_capacity(size));
 }
 
 // create an new empty array
 void v_init_array(var_t *var) {
-  v_capacity(var) = 0;
-  v_asize(var) = 0;
-  v_data(var) = NULL;
+  v_alloc_array(var, 0, 0);
   v_maxdim(var) = 1;
   v_ubound(var, 0) = opt_base;
   v_lbound(var, 0) = opt_base;
 }
 
-// create an array of the given size
+// create an array of the given size, without spare capacity since
+// the size of a dimensioned array rarely changes
 void v_new_array(var_t *var, uint32_t size) {
   var->type = V_ARRAY;
-  v_alloc_capacity(var, size);
+  v_alloc_array(var, size, size);
 }
 
 void v_set_array1_size(var_t *var, uint32_t size) {
@@ -122,13 +195,15 @@ void v_copy_array(var_t *dest, const var_t *src) {
 }
 
 void v_array_free(var_t *var) {
-  uint32_t v_size = v_capacity(var);
-  if (v_size && v_data(var)) {
-    for (uint32_t i = 0; i < v_size; i++) {
-      v_free(v_elem(var, i));
+  // elements beyond the size are always in the initial state
+  uint32_t v_size = v_asize(var);
+  for (uint32_t i = 0; i < v_size; i++) {
+    var_t *elem = v_elem(var, i);
+    if (elem->type != V_INT && elem->type != V_NUM) {
+      v_free(elem);
     }
-    free(var->v.a.data);
   }
+  free(v_bounds(var));
 }
 
 void v_init_str(var_t *var, int length) {
@@ -237,27 +312,21 @@ void v_resize_array(var_t *v, uint32_t size) {
     // use existing capacity
     v_set_array1_size(v, size);
   } else {
-    // insufficient capacity
+    // insufficient capacity, resize & copy along with the bounds
     uint32_t prev_size = v_asize(v);
-    if (prev_size == 0) {
-      v_alloc_capacity(v, size);
-    } else if (prev_size < size) {
-      // resize & copy
-      uint32_t capacity = v_get_capacity(size);
-      v_capacity(v) = capacity;
-      v_data(v) = (var_t *)realloc(v_data(v), sizeof(var_t) * capacity);
-      for (uint32_t i = prev_size; i < capacity; i++) {
-        var_t *e = v_elem(v, i);
-        e->pooled = 0;
-        v_init(e);
-      }
+    uint32_t capacity = v_get_capacity(size);
+    var_bounds_t *bounds = (var_bounds_t *)realloc(v_bounds(v), sizeof(var_bounds_t) + sizeof(var_t) * capacity);
+    if (!bounds) {
+      err_memory();
+      return;
     }
-
-    // init vars
-    for (uint32_t i = prev_size; i < size; i++) {
-      v_init(v_elem(v, i));
+    v_capacity(v) = capacity;
+    v_data(v) = (var_t *)(bounds + 1);
+    for (uint32_t i = prev_size; i < capacity; i++) {
+      var_t *e = v_elem(v, i);
+      e->pooled = 0;
+      v_init(e);
     }
-
     v_set_array1_size(v, size);
   }
 }
@@ -415,10 +484,12 @@ void v_add(var_t *result, var_t *a, var_t *b) {
   char tmpsb[INT_STR_LEN];
 
   if (a->type == V_STR && b->type == V_STR) {
-    int length = strlen(a->v.p.ptr) + strlen(b->v.p.ptr);
-    v_init_str(result, length);
-    strcpy(result->v.p.ptr, a->v.p.ptr);
-    strcat(result->v.p.ptr, b->v.p.ptr);
+    int len_a = v_strlen(a);
+    int len_b = v_strlen(b);
+    v_init_str(result, len_a + len_b);
+    memcpy(result->v.p.ptr, a->v.p.ptr, len_a);
+    memcpy(result->v.p.ptr + len_a, b->v.p.ptr, len_b);
+    result->v.p.ptr[len_a + len_b] = '\0';
     return;
   } else if (a->type == V_INT && b->type == V_INT) {
     result->type = V_INT;
@@ -445,15 +516,15 @@ void v_add(var_t *result, var_t *a, var_t *b) {
         result->v.n = b->v.n + v_getval(a);
       }
     } else {
-      v_init_str(result, strlen(a->v.p.ptr) + INT_STR_LEN);
-      strcpy(result->v.p.ptr, a->v.p.ptr);
+      int len_a = v_strlen(a);
       if (b->type == V_INT) {
         ltostr(b->v.i, tmpsb);
       } else {
         ftostr(b->v.n, tmpsb);
       }
-      strcat(result->v.p.ptr, tmpsb);
-      result->v.p.length = strlen(result->v.p.ptr) + 1;
+      v_init_str(result, len_a + strlen(tmpsb));
+      memcpy(result->v.p.ptr, a->v.p.ptr, len_a);
+      strcpy(result->v.p.ptr + len_a, tmpsb);
     }
   } else if ((a->type == V_INT || a->type == V_NUM) && b->type == V_STR) {
     if (is_number(b->v.p.ptr)) {
@@ -464,15 +535,17 @@ void v_add(var_t *result, var_t *a, var_t *b) {
         result->v.n = a->v.n + v_getval(b);
       }
     } else {
-      v_init_str(result, strlen(b->v.p.ptr) + INT_STR_LEN);
+      int len_b = v_strlen(b);
       if (a->type == V_INT) {
         ltostr(a->v.i, tmpsb);
       } else {
         ftostr(a->v.n, tmpsb);
       }
-      strcpy(result->v.p.ptr, tmpsb);
-      strcat(result->v.p.ptr, b->v.p.ptr);
-      result->v.p.length = strlen(result->v.p.ptr) + 1;
+      int len_a = strlen(tmpsb);
+      v_init_str(result, len_a + len_b);
+      memcpy(result->v.p.ptr, tmpsb, len_a);
+      memcpy(result->v.p.ptr + len_a, b->v.p.ptr, len_b);
+      result->v.p.ptr[len_a + len_b] = '\0';
     }
   } else if (b->type == V_MAP) {
     char *map = map_to_str(b);
@@ -499,10 +572,12 @@ void v_set(var_t *dest, const var_t *src) {
     break;
   case V_STR:
     if (src->v.p.owner) {
-      dest->v.p.length = v_strlen(src) + 1;
+      int len = v_strlen(src);
+      dest->v.p.length = len + 1;
       dest->v.p.ptr = (char *)malloc(dest->v.p.length);
       dest->v.p.owner = 1;
-      strcpy(dest->v.p.ptr, src->v.p.ptr);
+      memcpy(dest->v.p.ptr, src->v.p.ptr, len);
+      dest->v.p.ptr[len] = '\0';
     } else {
       dest->v.p.length = src->v.p.length;
       dest->v.p.ptr = src->v.p.ptr;
@@ -531,7 +606,6 @@ void v_set(var_t *dest, const var_t *src) {
   case V_FUNC:
     dest->v.fn.cb = src->v.fn.cb;
     dest->v.fn.mcb = src->v.fn.mcb;
-    dest->v.fn.id = src->v.fn.id;
     break;
   case V_NIL:
     dest->type = V_NIL;
@@ -570,8 +644,6 @@ void v_move(var_t *dest, const var_t *src) {
     break;
   case V_MAP:
     dest->v.m.map = src->v.m.map;
-    dest->v.m.count = src->v.m.count;
-    dest->v.m.size = src->v.m.size;
     dest->v.m.lib_id = src->v.m.lib_id;
     dest->v.m.cls_id = src->v.m.cls_id;
     dest->v.m.id = plugin_refresh_id(src->v.m.lib_id, src->v.m.cls_id, src->v.m.id);
@@ -581,7 +653,7 @@ void v_move(var_t *dest, const var_t *src) {
     break;
   case V_FUNC:
     dest->v.fn.cb = src->v.fn.cb;
-    dest->v.fn.id = src->v.fn.id;
+    dest->v.fn.mcb = src->v.fn.mcb;
     break;
   case V_NIL:
     dest->type = V_NIL;
@@ -708,6 +780,38 @@ void v_setstrn(var_t *var, const char *str, int len) {
   }
 }
 
+/*
+ * returns the buffer size used when a string grows by appending. rounding up
+ * to a power of two means realloc only moves the buffer when the size doubles
+ */
+static inline uint32_t v_str_capacity(uint32_t size) {
+  uint32_t result = 16;
+  while (result < size) {
+    result <<= 1;
+  }
+  return result;
+}
+
+/*
+ * appends len bytes to the string value
+ */
+void v_strappend(var_t *var, const char *str, int len) {
+  int length = v_strlen(var);
+  int size = v_str_capacity(length + len + 1);
+  if (var->v.p.owner) {
+    var->v.p.ptr = realloc(var->v.p.ptr, size);
+  } else {
+    // mutate into owner string
+    char *p = var->v.p.ptr;
+    var->v.p.ptr = malloc(size);
+    var->v.p.owner = 1;
+    memcpy(var->v.p.ptr, p, length);
+  }
+  memcpy(var->v.p.ptr + length, str, len);
+  var->v.p.ptr[length + len] = '\0';
+  var->v.p.length = length + len + 1;
+}
+
 /*
  * adds a string to current string value
  */
@@ -716,18 +820,7 @@ void v_strcat(var_t *var, const char *str) {
     v_tostr(var);
   }
   if (var->type == V_STR) {
-    if (var->v.p.owner) {
-      var->v.p.length = strlen(var->v.p.ptr) + strlen(str) + 1;
-      var->v.p.ptr = realloc(var->v.p.ptr, var->v.p.length);
-      strcat(var->v.p.ptr, str);
-    } else {
-      // mutate into owner string
-      char *p = var->v.p.ptr;
-      int len = var->v.p.length + strlen(str);
-      v_init_str(var, len);
-      strcpy(var->v.p.ptr, p);
-      strcat(var->v.p.ptr, str);
-    }
+    v_strappend(var, str, strlen(str));
   } else {
     err_typemismatch();
   }
@@ -808,7 +901,6 @@ void v_create_func(var_p_t map, const char *name, method cb) {
   v_func->type = V_FUNC;
   v_func->v.fn.cb = cb;
   v_func->v.fn.mcb = NULL;
-  v_func->v.fn.id = 0;
 }
 
 void v_create_callback(var_p_t map, const char *name, callback cb) {
@@ -816,5 +908,4 @@ void v_create_callback(var_p_t map, const char *name, callback cb) {
   v_func->type = V_FUNC;
   v_func->v.fn.cb = NULL;
   v_func->v.fn.mcb = cb;
-  v_func->v.fn.id = 0;
 }
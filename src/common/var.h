@@ -191,10 +191,19 @@ typedef struct stknode_s {
 /**
  * @ingroup var
  *
- * intialises the var pool
+ * intialises the var pool. the memory added to the pool is released
+ * only when none of the pooled vars is live
  */
 void v_init_pool(void);
 
+/**
+ * @ingroup var
+ *
+ * releases the memory added to the var pool after the last task has closed.
+ * with opt_verbose reports the pool statistics and any vars not released
+ */
+void v_close_pool(void);
+
 /**
  * @ingroup var
  *
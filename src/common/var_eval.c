@@ -68,6 +68,40 @@ void v_eval_func(var_p_t self, var_p_t v_func, var_p_t result) {
   }
 }
 
+/**
+ * Returns whether the next index is a numeric variable or an integer on its
+ * own, in which case the value is read without calling eval()
+ */
+static inline int get_simple_idx(bcip_t *idim) {
+  bcip_t next;
+  var_t *var_p = NULL;
+  switch (code_peek()) {
+  case kwTYPE_INT:
+    next = prog_ip + 1 + OS_INTSZ;
+    break;
+  case kwTYPE_VAR:
+    next = prog_ip + 1 + ADDRSZ;
+    var_p = tvar[code_peekaddr(prog_ip + 1)];
+    if (var_p->type != V_INT && var_p->type != V_NUM) {
+      return 0;
+    }
+    break;
+  default:
+    return 0;
+  }
+  if (prog_source[next] != kwTYPE_LEVEL_END && prog_source[next] != kwTYPE_SEP) {
+    return 0;
+  }
+  if (var_p == NULL) {
+    code_skipnext();
+    *idim = code_getint();
+  } else {
+    *idim = v_getint(var_p);
+    prog_ip = next;
+  }
+  return 1;
+}
+
 /**
  * Convert multi-dim index to one-dim index
  */
@@ -76,38 +110,40 @@ bcip_t get_array_idx(var_t *array) {
   bcip_t lev = 0;
 
   do {
-    var_t var;
-    v_init(&var);
-    eval(&var);
-
-    if (prog_error) {
-      break;
-    } else if (var.type == V_STR || array->type == V_MAP) {
-      err_varnotnum();
-      break;
-    } else {
-      bcip_t idim = v_getint(&var);
+    bcip_t idim;
+    if (array->type == V_MAP || !get_simple_idx(&idim)) {
+      var_t var;
+      v_init(&var);
+      eval(&var);
 
+      if (prog_error) {
+        break;
+      } else if (var.type == V_STR || array->type == V_MAP) {
+        err_varnotnum();
+        v_free(&var);
+        break;
+      }
+      idim = v_getint(&var);
       v_free(&var);
-      idim = idim - v_lbound(array, lev);
+    }
+    idim = idim - v_lbound(array, lev);
 
-      bcip_t m = idim;
-      for (bcip_t i = lev + 1; i < v_maxdim(array); i++) {
-        m = m * (ABS(v_ubound(array, i) - v_lbound(array, i)) + 1);
-      }
-      idx += m;
+    bcip_t m = idim;
+    for (bcip_t i = lev + 1; i < v_maxdim(array); i++) {
+      m = m * (ABS(v_ubound(array, i) - v_lbound(array, i)) + 1);
+    }
+    idx += m;
 
-      // skip separator
-      byte code = code_peek();
-      if (code == kwTYPE_SEP) {
-        code_skipnext();
-        if (code_getnext() != ',') {
-          err_missing_comma();
-        }
+    // skip separator
+    byte code = code_peek();
+    if (code == kwTYPE_SEP) {
+      code_skipnext();
+      if (code_getnext() != ',') {
+        err_missing_comma();
       }
-      // next
-      lev++;
     }
+    // next
+    lev++;
   } while (!prog_error && code_peek() != kwTYPE_LEVEL_END);
 
   if (!prog_error) {
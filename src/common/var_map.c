@@ -82,7 +82,7 @@ int map_to_int(const var_p_t var_p) {
 int map_length(const var_p_t var_p) {
   int result;
   if (var_p->type == V_MAP) {
-    result = var_p->v.m.count;
+    result = hashmap_count(var_p);
   } else {
     result = 0;
   }
@@ -134,36 +134,11 @@ const char *map_get_str(var_p_t base, const char *name) {
   return result;
 }
 
-//
-// return the element at the nth position
-//
-int map_elem_cb(hashmap_cb *cb, var_p_t key, var_p_t value) {
-  int result;
-  if (cb->count++ == cb->index) {
-    cb->var = key;
-    result = 1;
-  } else {
-    result = 0;
-  }
-  return result;
-}
-
 //
 // return the element key at the nth position
 //
 var_p_t map_elem_key(const var_p_t var_p, int index) {
-  var_p_t result;
-  if (var_p->type == V_MAP) {
-    hashmap_cb cb;
-    cb.count = 0;
-    cb.index = index;
-    cb.var = NULL;
-    hashmap_foreach(var_p, map_elem_cb, &cb);
-    result = cb.var;
-  } else {
-    result = NULL;
-  }
-  return result;
+  return hashmap_get_key(var_p, index);
 }
 
 //
@@ -212,6 +187,8 @@ var_p_t map_resolve_fields(var_p_t base, var_p_t *parent) {
   var_p_t field = NULL;
   if (code_peek() == kwTYPE_UDS_EL) {
     code_skipnext();
+    // the compiler stores the hash of the name ahead of the name
+    uint32_t hash = code_getnext32();
     if (code_peek() != kwTYPE_STR) {
       err_stackmess();
       return NULL;
@@ -235,7 +212,7 @@ var_p_t map_resolve_fields(var_p_t base, var_p_t *parent) {
     int len = code_getstrlen();
     const char *key = (const char *)&prog_source[prog_ip];
     prog_ip += len;
-    field = hashmap_putc(base, key, len);
+    field = hashmap_putc(base, key, len, hash);
     if (parent != NULL) {
       *parent = base;
     }
@@ -314,9 +291,8 @@ void map_set(var_p_t dest, const var_p_t src) {
   if (dest != src && src->type == V_MAP) {
     hashmap_cb cb;
     cb.var = dest;
-    hashmap_create(dest, src->v.m.count);
+    hashmap_create(dest, hashmap_count(src));
     hashmap_foreach(src, map_set_cb, &cb);
-    dest->v.m.count = src->v.m.count;
     dest->v.m.lib_id = src->v.m.lib_id;
     dest->v.m.cls_id = src->v.m.cls_id;
     dest->v.m.id = plugin_refresh_id(src->v.m.lib_id, src->v.m.cls_id, src->v.m.id);
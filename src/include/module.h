@@ -16,6 +16,16 @@
 extern "C" {
 #endif
 
+/**
+ * @ingroup modstd
+ *
+ * Returns the SBLIB_VERSION the library was built with. Libraries without
+ * this function, or built with another version, are not loaded.
+ *
+ * @return SBLIB_VERSION
+ */
+int sblib_version(void);
+
 /**
  * @ingroup modstd
  *
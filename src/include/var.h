@@ -17,6 +17,9 @@
 typedef double var_num_t;
 typedef long long int var_int_t;
 
+// changed when var_t or the module interface changes, see sblib_version()
+#define SBLIB_VERSION 2
+
 #define MAXDIM 6
 #define OS_INTSZ  sizeof(var_int_t)
 #define OS_REALSZ sizeof(var_num_t)
@@ -83,11 +86,9 @@ typedef struct var_s {
       // pointer to the map structure
       void *map;
 
-      uint32_t count;
-      uint32_t size;
       uint32_t id;
-      uint32_t lib_id;
-      uint32_t cls_id;
+      int16_t lib_id;
+      int16_t cls_id;
     } m;
 
     // reference variable
@@ -97,7 +98,6 @@ typedef struct var_s {
     struct {
       method cb;
       callback mcb;
-      uint32_t id;
     } fn;
 
     // generic ptr (string)
@@ -109,14 +109,12 @@ typedef struct var_s {
 
     // array
     struct {
+      // the elements, preceded by the var_bounds_t
       struct var_s *data;
       // the number of elements
       uint32_t size;
       // the number of available element slots
       uint32_t capacity;
-      // upper and lower bounds
-      int32_t ubound[MAXDIM];
-      int32_t lbound[MAXDIM];
     } a;
 
     // next item in the free-list
@@ -138,6 +136,12 @@ typedef struct var_s {
 
 typedef var_t *var_p_t;
 
+// array upper and lower bounds, allocated in front of the array elements
+typedef struct var_bounds_s {
+  int32_t ubound[MAXDIM];
+  int32_t lbound[MAXDIM];
+} var_bounds_t;
+
 /**
  * @ingroup var
  *
@@ -381,6 +385,18 @@ void v_setstrn(var_t *var, const char *string, int len);
  */
 void v_strcat(var_t *var, const char *string);
 
+/**
+ * @ingroup var
+ *
+ * appends len bytes to the string variable 'var'. the buffer grows
+ * geometrically so that building a string by appending is linear
+ *
+ * @param var is the string variable
+ * @param string is the string
+ * @param len is the number of bytes to append
+ */
+void v_strappend(var_t *var, const char *string, int len);
+
 /**
  * @ingroup var
  *
@@ -442,17 +458,23 @@ void v_input2var(const char *str, var_t *var);
  */
 #define v_maxdim(x) ((x)->maxdim)
 
+/**
+ * < the array bounds (x)
+ * @ingroup var
+ */
+#define v_bounds(x) (((var_bounds_t *)(x)->v.a.data) - 1)
+
 /**
  * < the array lower bound of the given dimension (x)
  * @ingroup var
  */
-#define v_lbound(x, i) ((x)->v.a.lbound[i])
+#define v_lbound(x, i) (v_bounds(x)->lbound[i])
 
 /**
  * < the array upper bound of the given dimension (x)
  * @ingroup var
  */
-#define v_ubound(x, i) ((x)->v.a.ubound[i])
+#define v_ubound(x, i) (v_bounds(x)->ubound[i])
 
 /**
  * < the array data
@@ -87,6 +87,7 @@ struct keyword_s keyword_table[] = {
 { "LINEINPUT",          kwLINEINPUT }, // The QB's keyword is "LINE INPUT"
 { "LINPUT",             kwLINEINPUT }, // The QB's keyword is "LINE INPUT"
 { "SEEK",               kwSEEK },
+{ "FLUSH",              kwFLUSH },
 { "WRITE",              kwFILEWRITE },
 { "INSERT",             kwINSERT },
 { "DELETE",             kwDELETE },
@@ -347,6 +348,8 @@ struct func_keyword_s func_table[] = {
 { "FORM",                       kwFORM },
 { "WINDOW",                     kwWINDOW },
 { "TIMESTAMP",                  kwTIMESTAMP },
+{ "REGEX",                      kwREGEX },
+{ "QUANTILE",                   kwQUANTILE },
 { "", 0 }
 };
 
@@ -378,6 +381,8 @@ struct proc_keyword_s proc_table[] = {
 { "PLAY",               kwPLAY },
 { "SORT",               kwSORT },
 { "SEARCH",             kwSEARCH },
+{ "BSEARCH",            kwBSEARCH },
+{ "CSVSPLIT",           kwCSVSPLIT },
 { "ROOT",               kwROOT },
 { "DIFFEQN",            kwDIFFEQ },
 { "CHART",              kwCHART },
@@ -451,6 +456,7 @@ struct proc_keyword_s proc_table[] = {
 #define LCN_DO_WS               " DO "
 #define LCN_NEXT                "NEXT"
 #define LCN_IN_WS               " IN "
+#define LCN_FILE                "FILE"
 #define LCN_WEND                "WEND"
 #define LCN_IF                  "IF"
 #define LCN_SELECT              "SELECT"
@@ -137,6 +137,8 @@
 #define WORD_GOTO               "GOTO"
 #define WORD_GOSUB              "GOSUB"
 #define WORD_INF                "INF" // infinity
+#define MSG_VAR_POOL            "VAR POOL: %llu allocs, %u slabs, %u vars allocated, %u live, peak %u live\n"
+#define MSG_VAR_POOL_LEAK       "VAR POOL: %u vars not released\n"
 #define FSERR_INVALID_PARAMETER "FS: Invalid parameter"
 #define FSERR_NOT_FOUND         "FS: File not found"
 #define FSERR_HANDLE            "FS: Invalid file handle"
@@ -43,9 +43,11 @@
 #include "common/smbas.h"
 #include "common/sberr.h"
 
-#ifdef USE_PCRE
+#if defined(USE_PCRE)
 #include <pcre.h>
 #define OVECCOUNT 30            /* should be a multiple of 3 */
+#elif defined(HAVE_REGEX_H)
+#include <regex.h>
 #endif
 
 int reg_match_after_star(const char *p, char *t);
@@ -247,40 +249,139 @@ int reg_match_jk(const char *p, char *t) {
   return reg_match_valid;
 }
 
-/*
+#if defined(REG_MATCH_RE)
+/**
+ * compiled pattern. when the cache is full the least recently used
+ * pattern is replaced
  */
-#ifdef USE_PCRE
-int reg_match_pcre(const char *p, char *t)
-{
+typedef struct reg_cache_t {
+  char *pattern;
+  int caseless;
+  uint32_t used;
+#if defined(USE_PCRE)
   pcre *re;
-  const char *error;
-  int errofs;
+#else
+  regex_t re;
+#endif
+} reg_cache_t;
+
+static reg_cache_t reg_cache[REG_CACHE_SIZE];
+static uint32_t reg_cache_clock;
+
+static void reg_cache_free(reg_cache_t *entry) {
+#if defined(USE_PCRE)
+  pcre_free(entry->re);
+#else
+  regfree(&entry->re);
+#endif
+  free(entry->pattern);
+  entry->pattern = NULL;
+  entry->used = 0;
+}
+
+/**
+ * returns the compiled pattern, compiling the pattern when not cached
+ */
+static reg_cache_t *reg_compile(const char *p, int caseless) {
+  reg_cache_t *result = NULL;
+  reg_cache_t *oldest = &reg_cache[0];
+
+  for (int i = 0; i < REG_CACHE_SIZE && result == NULL; i++) {
+    reg_cache_t *entry = &reg_cache[i];
+    if (entry->pattern != NULL && entry->caseless == caseless && strcmp(entry->pattern, p) == 0) {
+      result = entry;
+    } else if (entry->used < oldest->used) {
+      oldest = entry;
+    }
+  }
 
-  re =
-  pcre_compile(p, (opt_usepcre == 2) ? PCRE_CASELESS : 0, &error, &errofs, NULL);
-  if (!re) {
-    rt_raise("REGULAR EXPRESSION SYNTAX ERROR (offset %d) -> %s", errofs, error);
+  if (result == NULL) {
+    if (oldest->pattern != NULL) {
+      reg_cache_free(oldest);
+    }
+#if defined(USE_PCRE)
+    const char *error;
+    int errofs;
+    oldest->re = pcre_compile(p, caseless ? PCRE_CASELESS : 0, &error, &errofs, NULL);
+    if (oldest->re == NULL) {
+      rt_raise("REGULAR EXPRESSION SYNTAX ERROR (offset %d) -> %s", errofs, error);
+      return NULL;
+    }
+#else
+    int rc = regcomp(&oldest->re, p, REG_EXTENDED | (caseless ? REG_ICASE : 0));
+    if (rc != 0) {
+      char error[256];
+      regerror(rc, &oldest->re, error, sizeof(error));
+      rt_raise("REGULAR EXPRESSION SYNTAX ERROR -> %s", error);
+      return NULL;
+    }
+#endif
+    oldest->pattern = strdup(p);
+    oldest->caseless = caseless;
+    result = oldest;
+  }
+  result->used = ++reg_cache_clock;
+  return result;
+}
+
+int reg_search(const char *p, const char *t, int flags, reg_group_t *groups, int count) {
+  reg_cache_t *entry = reg_compile(p, flags & reg_search_caseless);
+  if (entry == NULL) {
     return reg_match_bad_pattern;
   }
-  else {
-    int rc;
-    int ovector[OVECCOUNT];
 
-    rc = pcre_exec(re, NULL, t, strlen(t), 0, 0, ovector, OVECCOUNT);
-    if (rc >= 0)
-    return reg_match_valid;
+  int result = 0;
+#if defined(USE_PCRE)
+  int ovector[OVECCOUNT];
+  int options = (flags & reg_search_notbol) ? PCRE_NOTBOL : 0;
+  int rc = pcre_exec(entry->re, NULL, t, strlen(t), 0, options, ovector, OVECCOUNT);
+  if (rc >= 0) {
+    result = rc == 0 ? OVECCOUNT / 3 : rc;
+    for (int i = 0; i < count; i++) {
+      groups[i].start = i < result ? ovector[i * 2] : -1;
+      groups[i].end = i < result ? ovector[i * 2 + 1] : -1;
+    }
+  }
+#else
+  regmatch_t match[REG_MATCH_GROUPS];
+  int options = (flags & reg_search_notbol) ? REG_NOTBOL : 0;
+  if (regexec(&entry->re, t, count, match, options) == 0) {
+    for (int i = 0; i < count; i++) {
+      groups[i].start = match[i].rm_so;
+      groups[i].end = match[i].rm_eo;
+      if (match[i].rm_so != -1) {
+        result = i + 1;
+      }
+    }
   }
+#endif
+  return result;
+}
 
-  return reg_match_literal_failure;
+/*
+ */
+static int reg_match_re(const char *p, char *t) {
+  reg_group_t group;
+  int rc = reg_search(p, t, opt_usepcre == 2 ? reg_search_caseless : 0, &group, 1);
+  if (rc == reg_match_bad_pattern) {
+    return rc;
+  }
+  return rc > 0 ? reg_match_valid : reg_match_literal_failure;
+}
+#else
+int reg_search(const char *p, const char *t, int flags, reg_group_t *groups, int count) {
+  rt_raise("REGULAR EXPRESSIONS ARE NOT SUPPORTED");
+  return reg_match_bad_pattern;
 }
 #endif
 
 /*
  */
 int reg_match(const char *p, char *t) {
-#ifdef USE_PCRE
-  if (opt_usepcre)
-  return reg_match_pcre(p, t);
+#if defined(REG_MATCH_RE)
+  if (opt_usepcre) {
+    return reg_match_re(p, t);
+  }
 #endif
   return reg_match_jk(p, t);
 }
@@ -66,4 +66,43 @@
  */
 int reg_match(const char *p, char *t);
 
+#if defined(USE_PCRE) || defined(HAVE_REGEX_H)
+#define REG_MATCH_RE
+#endif
+
+// the maximum number of groups, including the whole match
+#define REG_MATCH_GROUPS 10
+
+// the number of compiled regular expressions kept for reuse
+#define REG_CACHE_SIZE 16
+
+/* reg_search flags */
+#define reg_search_caseless 1 // ignore case
+#define reg_search_notbol   2 // the text does not begin a line
+
+/**
+ * @ingroup str
+ *
+ * the offsets of a matched group, or -1 when the group did not match
+ */
+typedef struct reg_group_t {
+  int start;
+  int end;
+} reg_group_t;
+
+/**
+ * @ingroup str
+ *
+ * searches the text for the regular expression. the compiled pattern is
+ * cached for the next call with the same pattern and flags.
+ *
+ * @param p is the regular expression
+ * @param t is the text
+ * @param flags reg_search_caseless, reg_search_notbol
+ * @param groups receives the whole match followed by the matched groups
+ * @param count the number of groups, up to REG_MATCH_GROUPS
+ * @return the number of groups set, 0 when not found or reg_match_bad_pattern
+ */
+int reg_search(const char *p, const char *t, int flags, reg_group_t *groups, int count);
+
 #endif
@@ -26,185 +26,398 @@
 #include "common/sys.h"
 #include "common/blib_math.h"
 
-// creates a matrix of the given size
-var_num_t **mat_create(int row, int col) {
-  var_num_t **m = (var_num_t **)malloc(sizeof(var_num_t *) * row);
-  int i;
-  for (i = 0; i < row; i++) {
-    m[i] = (var_num_t *)malloc(sizeof(var_num_t) * col);
+// the product is computed in blocks of MAT_DEPTH rows of b by MAT_WIDTH
+// columns, small enough to stay in the cache while the rows of a pass by
+#define MAT_DEPTH 128
+#define MAT_WIDTH 256
+
+// the rows and columns of c updated together by mat_gemm_tile
+#define MAT_TILE 4
+
+// the number of columns factored together in the LU decomposition
+#define MAT_PANEL 64
+
+// the number of multiplications before the product is shared between threads
+#define MAT_PARALLEL (128 * 128 * 128)
+#define MAT_MAX_THREADS 8
+
+typedef struct mat_gemm_t {
+  const var_num_t *a;
+  const var_num_t *b;
+  var_num_t *c;
+  int m, n, k;
+  int lda, ldb, ldc;
+  var_num_t sign;
+} mat_gemm_t;
+
+/**
+ * updates the 4 x 4 block of c at row i, column j with the kb products
+ * from k0. b holds the four columns of b packed together. the block is
+ * held in local variables which the compiler keeps in (vector) registers
+ */
+static inline void mat_gemm_tile(const mat_gemm_t *g, int i, int j, int k0, int kb,
+                                 const var_num_t *b) {
+  var_num_t *c0 = g->c + i * g->ldc + j;
+  var_num_t *c1 = c0 + g->ldc;
+  var_num_t *c2 = c1 + g->ldc;
+  var_num_t *c3 = c2 + g->ldc;
+  const var_num_t *a0 = g->a + i * g->lda + k0;
+  const var_num_t *a1 = a0 + g->lda;
+  const var_num_t *a2 = a1 + g->lda;
+  const var_num_t *a3 = a2 + g->lda;
+  var_num_t c00 = c0[0], c01 = c0[1], c02 = c0[2], c03 = c0[3];
+  var_num_t c10 = c1[0], c11 = c1[1], c12 = c1[2], c13 = c1[3];
+  var_num_t c20 = c2[0], c21 = c2[1], c22 = c2[2], c23 = c2[3];
+  var_num_t c30 = c3[0], c31 = c3[1], c32 = c3[2], c33 = c3[3];
+
+  for (int k = 0; k < kb; k++, b += MAT_TILE) {
+    var_num_t b0 = b[0], b1 = b[1], b2 = b[2], b3 = b[3];
+    var_num_t s0 = g->sign * a0[k];
+    var_num_t s1 = g->sign * a1[k];
+    var_num_t s2 = g->sign * a2[k];
+    var_num_t s3 = g->sign * a3[k];
+    c00 += s0 * b0;
+    c01 += s0 * b1;
+    c02 += s0 * b2;
+    c03 += s0 * b3;
+    c10 += s1 * b0;
+    c11 += s1 * b1;
+    c12 += s1 * b2;
+    c13 += s1 * b3;
+    c20 += s2 * b0;
+    c21 += s2 * b1;
+    c22 += s2 * b2;
+    c23 += s2 * b3;
+    c30 += s3 * b0;
+    c31 += s3 * b1;
+    c32 += s3 * b2;
+    c33 += s3 * b3;
   }
 
-  return m;
+  c0[0] = c00;
+  c0[1] = c01;
+  c0[2] = c02;
+  c0[3] = c03;
+  c1[0] = c10;
+  c1[1] = c11;
+  c1[2] = c12;
+  c1[3] = c13;
+  c2[0] = c20;
+  c2[1] = c21;
+  c2[2] = c22;
+  c2[3] = c23;
+  c3[0] = c30;
+  c3[1] = c31;
+  c3[2] = c32;
+  c3[3] = c33;
+}
+
+/**
+ * updates the elements of c outside of the whole tiles
+ */
+static void mat_gemm_edge(const mat_gemm_t *g, int i, int i1, int j, int j1, int k0, int kb) {
+  for (; i < i1; i++) {
+    const var_num_t *a = g->a + i * g->lda + k0;
+    var_num_t *c = g->c + i * g->ldc;
+    for (int k = 0; k < kb; k++) {
+      const var_num_t *b = g->b + (k0 + k) * g->ldb;
+      var_num_t s = g->sign * a[k];
+      for (int x = j; x < j1; x++) {
+        c[x] += s * b[x];
+      }
+    }
+  }
 }
 
-// free an allocated matrix
-void mat_free(var_num_t **m, int n) {
-  int i;
-  for (i = 0; i < n; i++) {
-    free(m[i]);
+/**
+ * c[m x n] += sign * a[m x k] * b[k x n]
+ *
+ * each element is summed in the order of k, so the result matches the plain
+ * triple loop. b is visited in blocks which stay in the cache while the
+ * rows of a pass by
+ */
+static void mat_gemm_block(const mat_gemm_t *g) {
+  var_num_t *pack = (var_num_t *)malloc(sizeof(var_num_t) * MAT_DEPTH * MAT_WIDTH);
+  int m = pack == NULL ? 0 : g->m - g->m % MAT_TILE;
+  for (int j0 = 0; j0 < g->n; j0 += MAT_WIDTH) {
+    int j1 = g->n - j0 < MAT_WIDTH ? g->n : j0 + MAT_WIDTH;
+    int jt = j1 - (j1 - j0) % MAT_TILE;
+    for (int k0 = 0; k0 < g->k; k0 += MAT_DEPTH) {
+      int kb = g->k - k0 < MAT_DEPTH ? g->k - k0 : MAT_DEPTH;
+      if (m) {
+        // copy the block of b into contiguous strips of MAT_TILE columns
+        for (int j = j0; j < jt; j += MAT_TILE) {
+          var_num_t *strip = pack + (j - j0) * kb;
+          for (int k = 0; k < kb; k++) {
+            const var_num_t *b = g->b + (k0 + k) * g->ldb + j;
+            for (int x = 0; x < MAT_TILE; x++) {
+              strip[k * MAT_TILE + x] = b[x];
+            }
+          }
+        }
+      }
+      for (int i = 0; i < m; i += MAT_TILE) {
+        for (int j = j0; j < jt; j += MAT_TILE) {
+          mat_gemm_tile(g, i, j, k0, kb, pack + (j - j0) * kb);
+        }
+        mat_gemm_edge(g, i, i + MAT_TILE, jt, j1, k0, kb);
+      }
+      mat_gemm_edge(g, m, g->m, j0, j1, k0, kb);
+    }
   }
-  free(m);
+  free(pack);
+}
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#include <unistd.h>
+
+static void *mat_gemm_thread(void *arg) {
+  mat_gemm_block((mat_gemm_t *)arg);
+  return NULL;
 }
 
-// fill the matrix with zero values
-void mat_fill(var_num_t **A, int row, int col) {
-  int i, j;
+/**
+ * shares the rows of c between the available processors
+ */
+static int mat_gemm_parallel(const mat_gemm_t *g) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int parts = cpus < MAT_MAX_THREADS ? cpus : MAT_MAX_THREADS;
+  if (parts > g->m / MAT_TILE) {
+    parts = g->m / MAT_TILE;
+  }
+  if (parts < 2) {
+    return 0;
+  }
 
-  for (i = 0; i < row; i++) {
-    for (j = 0; j < col; j++) {
-      A[i][j] = 0.0;
+  mat_gemm_t task[MAT_MAX_THREADS];
+  pthread_t thread[MAT_MAX_THREADS];
+  int started[MAT_MAX_THREADS];
+  for (int p = 0; p < parts; p++) {
+    // keep the rows in whole tiles for the kernel
+    int start = (g->m * p / parts) / MAT_TILE * MAT_TILE;
+    int end = p + 1 == parts ? g->m : (g->m * (p + 1) / parts) / MAT_TILE * MAT_TILE;
+    task[p] = *g;
+    task[p].a = g->a + start * g->lda;
+    task[p].c = g->c + start * g->ldc;
+    task[p].m = end - start;
+  }
+  for (int p = 1; p < parts; p++) {
+    started[p] = pthread_create(&thread[p], NULL, mat_gemm_thread, &task[p]) == 0;
+    if (!started[p]) {
+      mat_gemm_block(&task[p]);
+    }
+  }
+  mat_gemm_block(&task[0]);
+  for (int p = 1; p < parts; p++) {
+    if (started[p]) {
+      pthread_join(thread[p], NULL);
     }
   }
+  return 1;
+}
+#endif
+
+static void mat_gemm(mat_gemm_t *g) {
+  int done = 0;
+#if defined(HAVE_PTHREAD)
+  if ((double)g->m * g->n * g->k >= MAT_PARALLEL) {
+    done = mat_gemm_parallel(g);
+  }
+#endif
+  if (!done) {
+    mat_gemm_block(g);
+  }
+}
+
+/*
+ * c[m x n] = a[m x k] * b[k x n]
+ */
+void mat_product(const var_num_t *a, const var_num_t *b, var_num_t *c, int m, int n, int k) {
+  mat_gemm_t g = {a, b, c, m, n, k, k, n, n, 1.0};
+  for (int i = 0; i < m * n; i++) {
+    c[i] = 0.0;
+  }
+  mat_gemm(&g);
+}
+
+static void mat_swap_rows(var_num_t *a, int r1, int r2, int n) {
+  var_num_t *p1 = a + r1 * n;
+  var_num_t *p2 = a + r2 * n;
+  for (int j = 0; j < n; j++) {
+    var_num_t t = p1[j];
+    p1[j] = p2[j];
+    p2[j] = t;
+  }
 }
 
 /*
  *-----------------------------------------------------------------------------
  *       funct:  mat_lu
  *       desct:  in-place LU decomposition with partial pivoting
- *       given:  !! A = square matrix (n x n) !ATTENTION! see commen
- *               P = permutation vector (n x 1)
+ *       given:  !! a = square matrix (n x n) !ATTENTION! see commen
+ *               p = permutation vector (n)
  *       retrn:  number of permutation performed
  *               -1 means suspected singular matrix
- *       comen:  A will be overwritten to be a LU-composite matrix
+ *       comen:  a will be overwritten to be a LU-composite matrix with
+ *               the rows interchanged, row i holds the original row p[i]
  *
- *       note:   the LU decomposed may NOT be equal to the LU of
- *               the orignal matrix a. But equal to the LU of the
- *               rows interchanged matrix.
+ *       note:   the columns are factored in panels of MAT_PANEL. the rest
+ *               of the matrix is updated once per panel as a product
  *-----------------------------------------------------------------------------
  */
-int mat_lu(var_num_t **A, var_num_t **P, int n) {
-  int i, j, k, maxi, tmp, p;
-  var_num_t c, c1;
+int mat_lu(var_num_t *a, int *p, int n) {
+  int count = 0;
 
-  for (p = 0, i = 0; i < n; i++) {
-    P[i][0] = i;
+  for (int i = 0; i < n; i++) {
+    p[i] = i;
   }
 
-  for (k = 0; k < n; k++) {
-    /*
-     * --- partial pivoting ---
-     */
-    for (i = k, maxi = k, c = 0.0; i < n; i++) {
-      c1 = fabsl(A[(int) P[i][0]][k]);
-      if (c1 > c) {
-        c = c1;
-        maxi = i;
+  for (int k0 = 0; k0 < n; k0 += MAT_PANEL) {
+    int end = n - k0 < MAT_PANEL ? n : k0 + MAT_PANEL;
+
+    for (int k = k0; k < end; k++) {
+      // partial pivoting
+      int maxi = k;
+      var_num_t c = 0.0;
+      for (int i = k; i < n; i++) {
+        var_num_t c1 = fabs(a[i * n + k]);
+        if (c1 > c) {
+          c = c1;
+          maxi = i;
+        }
       }
-    }
 
-    /*
-     * row exchange, update permutation vector
-     */
-    if (k != maxi) {
-      p++;
-      tmp = P[k][0];
-      P[k][0] = P[maxi][0];
-      P[maxi][0] = tmp;
-    }
+      // row exchange, update permutation vector
+      if (k != maxi) {
+        count++;
+        mat_swap_rows(a, k, maxi, n);
+        int tmp = p[k];
+        p[k] = p[maxi];
+        p[maxi] = tmp;
+      }
 
-    /*
-     * suspected singular matrix
-     */
-    if (A[(int) P[k][0]][k] == 0.0) {
-      return -1;
-    }
+      // suspected singular matrix
+      var_num_t pivot = a[k * n + k];
+      if (pivot == 0.0) {
+        return -1;
+      }
 
-    for (i = k + 1; i < n; i++) {
-      /*
-       * --- calculate m(i,j) ---
-       */
-      A[(int) P[i][0]][k] = A[(int) P[i][0]][k] / A[(int) P[k][0]][k];
-
-      /*
-       * --- elimination ---
-       */
-      for (j = k + 1; j < n; j++) {
-        A[(int) P[i][0]][j] -= A[(int) P[i][0]][k] * A[(int) P[k][0]][j];
+      // calculate m(i,k) and eliminate within the panel
+      const var_num_t *restrict rk = a + k * n;
+      for (int i = k + 1; i < n; i++) {
+        var_num_t *restrict ri = a + i * n;
+        ri[k] = ri[k] / pivot;
+        var_num_t m = ri[k];
+        for (int j = k + 1; j < end; j++) {
+          ri[j] -= m * rk[j];
+        }
       }
     }
-  }
-
-  return p;
-}
 
-/*
- *-----------------------------------------------------------------------------
- *       funct:  mat_backsubs1
- *       desct:  back substitution
- *       given:  A = square matrix A (LU composite)
- *               !! B = column matrix B (attention!, see comen)
- *               !! X = place to put the result of X
- *               P = Permutation vector (after calling mat_lu)
- *               xcol = column of x to put the result
- *       retrn:  column matrix X (of AX = B)
- *       comen:  B will be overwritten
- *-----------------------------------------------------------------------------
- */
-var_num_t **mat_backsubs1(var_num_t **A, var_num_t **B, var_num_t **X, var_num_t **P, int xcol, int n) {
-  int i, j, k;
-  var_num_t sum;
-
-  for (k = 0; k < n; k++) {
-    for (i = k + 1; i < n; i++) {
-      B[(int) P[i][0]][0] -= A[(int) P[i][0]][k] * B[(int) P[k][0]][0];
-    }
-  }
+    if (end < n) {
+      // the rows of U to the right of the panel
+      for (int k = k0; k < end; k++) {
+        const var_num_t *restrict rk = a + k * n;
+        for (int i = k + 1; i < end; i++) {
+          var_num_t *restrict ri = a + i * n;
+          var_num_t m = ri[k];
+          for (int j = end; j < n; j++) {
+            ri[j] -= m * rk[j];
+          }
+        }
+      }
 
-  X[n - 1][xcol] = B[(int) P[n - 1][0]][0] / A[(int) P[n - 1][0]][n - 1];
-  for (k = n - 2; k >= 0; k--) {
-    sum = 0.0;
-    for (j = k + 1; j < n; j++) {
-      sum += A[(int) P[k][0]][j] * X[j][xcol];
+      // the remaining rows less the product of the panel and the rows of U
+      mat_gemm_t g = {a + end * n + k0, a + k0 * n + end, a + end * n + end,
+                      n - end, n - end, end - k0, n, n, n, -1.0};
+      mat_gemm(&g);
     }
-    X[k][xcol] = (B[(int) P[k][0]][0] - sum) / A[(int) P[k][0]][k];
   }
 
-  return X;
+  return count;
 }
 
 /*
  *-----------------------------------------------------------------------------
- *      funct:  mat_inv
+ *      funct:  mat_inverse
  *      desct:  find inverse of a matrix
  *      given:  a = square matrix a
  *      retrn:  square matrix Inverse(A)
- *              NULL = fails, singular matrix, or malloc() fails
+ *              a is unchanged when the matrix is singular
+ *      comen:  solves L U X = P I for all the columns of X at once, so each
+ *              step works along the contiguous rows. as with mat_lu the
+ *              rows are taken in panels, the rest updated as a product
  *-----------------------------------------------------------------------------
  */
 void mat_inverse(var_num_t *a, const int n) {
-  var_num_t **A = mat_create(n, n);
-  var_num_t **B = mat_create(n, 1);
-  var_num_t **C = mat_create(n, n);
-  var_num_t **P = mat_create(n, 1);
+  var_num_t *lu = (var_num_t *)malloc(sizeof(var_num_t) * n * n);
+  var_num_t *x = (var_num_t *)malloc(sizeof(var_num_t) * n * n);
+  var_num_t *sum = (var_num_t *)malloc(sizeof(var_num_t) * n);
+  int *p = (int *)malloc(sizeof(int) * n);
 
-  int i, j;
+  memcpy(lu, a, sizeof(var_num_t) * n * n);
 
-  // copy input matrix to working buffer
-  for (i = 0; i < n; i++) {
-    for (j = 0; j < n; j++) {
-      A[i][j] = a[i * n + j];
+  // LU-decomposition, also check for singular matrix
+  if (mat_lu(lu, p, n) != -1) {
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        x[i * n + j] = (p[i] == j) ? 1.0 : 0.0;
+      }
     }
-  }
 
-  // LU-decomposition, also check for singular matrix
-  if (mat_lu(A, P, n) != -1) {
-    for (i = 0; i < n; i++) {
-      mat_fill(B, n, 1);
-      B[i][0] = 1.0;
-      mat_backsubs1(A, B, C, P, i, n);
+    // forward substitution, a panel of rows at a time. the rows below
+    // the panel are updated as a product
+    for (int k0 = 0; k0 < n; k0 += MAT_PANEL) {
+      int end = n - k0 < MAT_PANEL ? n : k0 + MAT_PANEL;
+      for (int k = k0; k < end; k++) {
+        const var_num_t *restrict xk = x + k * n;
+        for (int i = k + 1; i < end; i++) {
+          var_num_t *restrict xi = x + i * n;
+          var_num_t m = lu[i * n + k];
+          for (int j = 0; j < n; j++) {
+            xi[j] -= m * xk[j];
+          }
+        }
+      }
+      if (end < n) {
+        mat_gemm_t g = {lu + end * n + k0, x + k0 * n, x + end * n,
+                        n - end, n, end - k0, n, n, n, -1.0};
+        mat_gemm(&g);
+      }
     }
 
-    // copy the result in C back to a
-    for (i = 0; i < n; i++) {
-      for (j = 0; j < n; j++) {
-        a[i * n + j] = C[i][j];
+    // back substitution, from the last panel of rows up
+    for (int end = n; end > 0; end -= MAT_PANEL) {
+      int k0 = end > MAT_PANEL ? end - MAT_PANEL : 0;
+      if (end < n) {
+        mat_gemm_t g = {lu + k0 * n + end, x + end * n, x + k0 * n,
+                        end - k0, n, n - end, n, n, n, -1.0};
+        mat_gemm(&g);
+      }
+      for (int k = end - 1; k >= k0; k--) {
+        var_num_t *restrict xk = x + k * n;
+        for (int j = 0; j < n; j++) {
+          sum[j] = 0.0;
+        }
+        for (int i = k + 1; i < end; i++) {
+          const var_num_t *restrict xi = x + i * n;
+          var_num_t m = lu[k * n + i];
+          for (int j = 0; j < n; j++) {
+            sum[j] += m * xi[j];
+          }
+        }
+        var_num_t d = lu[k * n + k];
+        for (int j = 0; j < n; j++) {
+          xk[j] = (xk[j] - sum[j]) / d;
+        }
       }
     }
+    memcpy(a, x, sizeof(var_num_t) * n * n);
   }
 
-  // release memory
-  mat_free(P, n);
-  mat_free(C, n);
-  mat_free(B, n);
-  mat_free(A, n);
+  free(p);
+  free(sum);
+  free(x);
+  free(lu);
 }
@@ -62,6 +62,31 @@ size_t strlcat(char *dst, const char *src, size_t siz) {
 }
 #endif
 
+#if !defined(HAVE_MEMMEM)
+void *memmem(const void *haystack, size_t haystacklen, const void *needle, size_t needlelen) {
+  const unsigned char *h = haystack;
+  const unsigned char *n = needle;
+
+  if (needlelen == 0) {
+    return (void *)haystack;
+  }
+
+  // use memchr to skip to each occurrence of the first byte
+  while (haystacklen >= needlelen) {
+    const unsigned char *p = memchr(h, n[0], haystacklen - needlelen + 1);
+    if (p == NULL) {
+      break;
+    }
+    if (memcmp(p + 1, n + 1, needlelen - 1) == 0) {
+      return (void *)p;
+    }
+    haystacklen -= (p + 1) - h;
+    h = p + 1;
+  }
+  return NULL;
+}
+#endif
+
 #if defined(_MCU)
 #include <ctype.h>
 char* strcasestr(const char *haystack, const char *needle) {
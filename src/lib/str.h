@@ -45,6 +45,15 @@ size_t strlcpy(char *dst, const char *src, size_t siz);
 size_t strlcat(char *dst, const char *src, size_t siz);
 #endif
 
+/**
+ * Locates the first occurrence of needle in the haystack, both of the
+ * given lengths. Returns NULL when not found. Without _GNU_SOURCE, glibc
+ * has memmem but does not declare it.
+ */
+#if !defined(HAVE_MEMMEM) || !defined(_GNU_SOURCE)
+void *memmem(const void *haystack, size_t haystacklen, const void *needle, size_t needlelen);
+#endif
+
 #if defined(_MCU)
 char *strcasestr(const char *haystack, const char *needle);
 #endif
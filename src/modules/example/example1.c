@@ -13,6 +13,10 @@ const char *sblib_get_module_name() {
   return "example";
 }
 
+int sblib_version(void) {
+  return SBLIB_VERSION;
+}
+
 /**
  * prints a var_t
  */
@@ -451,6 +451,10 @@ struct LibFuncs {
   {"OPENBLUETOOTH", cmd_bluetooth_connect}
 };
 
+extern "C" int sblib_version(void) {
+  return SBLIB_VERSION;
+}
+
 extern "C" int sblib_proc_count(void) {
   return (sizeof(lib_procs) / sizeof(lib_procs[0]));
 }
@@ -138,6 +138,9 @@ void dump_bytecode(FILE *output) {
     case kwTYPE_EVPOP:
       fprintf(output, "pop (l)eft");
       break;
+    case kwTYPE_EVPRIM:
+      fprintf(output, "move (r)esult to (l)eft");
+      break;
     case kwTYPE_EOC:
       fprintf(output, "end-of-command");
       break;
@@ -327,6 +330,9 @@ void dump_bytecode(FILE *output) {
         case kwTYPE_VAR:
         fprintf(output, "id %d ", code_getaddr());
         break;
+        case kwTYPE_UDS_EL:
+        fprintf(output, "hash 0x%X ", code_getnext32());
+        break;
         case kwTYPE_INT:
         lng = code_getint();
         fprintf(output, "value (int) %d (0x%X) ", (int)lng, (int)lng);
@@ -34,7 +34,9 @@ inline double fpart(double x) {
   { __typeof__(a) tmp; tmp = a; (a) = b; (b) = tmp; }
 
 Font::Font(FT_Face face, int size, bool italic) :
-  _face(face) {
+  _fixedW(0),
+  _face(face),
+  _atlas(nullptr) {
   FT_Set_Pixel_Sizes(face, 0, size);
   _spacing = 1 + (FT_MulFix(_face->height, _face->size->metrics.x_scale) / 64);
   _h = (FT_MulFix(_face->ascender, _face->size->metrics.x_scale) / 64) +
@@ -47,36 +49,69 @@ Font::Font(FT_Face face, int size, bool italic) :
     matrix.yy = 0x10000L;
   }
 
+  FT_Glyph slot[MAX_GLYPHS]{};
+  int atlasSize = 0;
   for (int i = 0; i < MAX_GLYPHS; i++) {
-    FT_UInt slot = FT_Get_Char_Index(face, i);
-    FT_Error error = FT_Load_Glyph(face, slot, FT_LOAD_TARGET_LIGHT);
+    FT_UInt index = FT_Get_Char_Index(face, i);
+    FT_Error error = FT_Load_Glyph(face, index, FT_LOAD_TARGET_LIGHT);
     if (error) {
       trace("Failed to load %d", i);
     }
-    error = FT_Get_Glyph(face->glyph, &_glyph[i]._slot);
+    error = FT_Get_Glyph(face->glyph, &slot[i]);
     if (error) {
       trace("Failed to get glyph %d", i);
+      slot[i] = nullptr;
+      continue;
     }
     if (italic) {
-      FT_Glyph_Transform(_glyph[i]._slot, &matrix, nullptr );
+      FT_Glyph_Transform(slot[i], &matrix, nullptr );
     }
     FT_Vector origin;
     origin.x = 0;
     origin.y = 0;
-    error = FT_Glyph_To_Bitmap(&_glyph[i]._slot, FT_RENDER_MODE_LIGHT, &origin, 1);
+    error = FT_Glyph_To_Bitmap(&slot[i], FT_RENDER_MODE_LIGHT, &origin, 1);
     if (error) {
       trace("Failed to get bitmap %d", i);
+      FT_Done_Glyph(slot[i]);
+      slot[i] = nullptr;
+      continue;
     }
+    auto bitmap = (FT_BitmapGlyph)slot[i];
     _glyph[i]._w = (int)(face->glyph->metrics.horiAdvance / 64);
+    _glyph[i]._left = bitmap->left;
+    _glyph[i]._top = bitmap->top;
+    _glyph[i]._width = (int)bitmap->bitmap.width;
+    _glyph[i]._rows = (int)bitmap->bitmap.rows;
+    _glyph[i]._offset = atlasSize;
+    atlasSize += _glyph[i]._width * _glyph[i]._rows;
   }
-}
 
-Font::~Font() {
+  // copy the bitmaps into the atlas, without the row padding
+  _atlas = new uint8_t[atlasSize + 1];
+  for (int i = 0; i < MAX_GLYPHS; i++) {
+    if (slot[i]) {
+      const FT_Bitmap *bitmap = &((FT_BitmapGlyph)slot[i])->bitmap;
+      for (int y = 0; y < _glyph[i]._rows; y++) {
+        memcpy(_atlas + _glyph[i]._offset + y * _glyph[i]._width,
+               bitmap->buffer + y * bitmap->pitch, _glyph[i]._width);
+      }
+      FT_Done_Glyph(slot[i]);
+    }
+  }
+
+  _fixedW = _glyph[0]._w;
   for (auto & i : _glyph) {
-    FT_Done_Glyph(i._slot);
+    if (i._w != _fixedW) {
+      _fixedW = 0;
+      break;
+    }
   }
 }
 
+Font::~Font() {
+  delete [] _atlas;
+}
+
 //
 // Graphics implementation
 //
@@ -316,36 +351,38 @@ void Graphics::drawRGB(const MAPoint2d *dstPoint, const void *src,
   }
 }
 
-void Graphics::drawChar(FT_Bitmap *bitmap, FT_Int x, FT_Int y) const {
-  FT_Int xMax = x + bitmap->width;
-  FT_Int yMax = y + bitmap->rows;
-
-  uint8_t sR, sG, sB;
-  GET_RGB(_drawColor, sR, sG, sB);
-
-  int dtX = _drawTarget->x();
-  int dtY = _drawTarget->y();
-  int dtW = _drawTarget->w();
-  int dtH = _drawTarget->h();
-
-  for (FT_Int j = y, q = 0; j < yMax; j++, q++) {
-    if (j >= dtY && j < dtH) {
-      pixel_t *line = _drawTarget->getLine(j);
-      for (FT_Int i = x, p = 0; i < xMax; i++, p++) {
-        if (i >= dtX && i < dtW) {
-          uint8_t a = bitmap->buffer[q * bitmap->width + p];
-          if (a == 255) {
-            line[i] = _drawColor;
-          } else {
-            // blend drawColor to the background
-            uint8_t dR, dG, dB;
-            GET_RGB(line[i], dR, dG, dB);
-            dR = dR + ((sR - dR) * a / 255);
-            dG = dG + ((sG - dG) * a / 255);
-            dB = dB + ((sB - dB) * a / 255);
-            line[i] = GET_RGB_PX(dR, dG, dB);
-          }
-        }
+//
+// blends the draw colour over the pixel by the glyph's coverage (a). the
+// colour is split into the red/blue and alpha/green channels (rb, ag) so
+// that two channels are blended with each multiply, the division by 255
+// is rounded
+//
+inline pixel_t blendChar(pixel_t px, pixel_t rb, pixel_t ag, pixel_t a) {
+  pixel_t na = 255 - a;
+  pixel_t t1 = rb * a + (px & 0x00ff00ff) * na + 0x00800080;
+  pixel_t t2 = ag * a + ((px >> 8) & 0x00ff00ff) * na + 0x00800080;
+  t1 = ((t1 + ((t1 >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+  t2 = (t2 + ((t2 >> 8) & 0x00ff00ff)) & 0xff00ff00;
+  return 0xff000000 | t1 | t2;
+}
+
+void Graphics::drawChar(const Glyph *glyph, int x, int y, pixel_t rb, pixel_t ag) const {
+  // clip the glyph once rather than for each pixel
+  int x1 = MAX(x, _drawTarget->x());
+  int y1 = MAX(y, _drawTarget->y());
+  int x2 = MIN(x + glyph->_width, _drawTarget->w());
+  int y2 = MIN(y + glyph->_rows, _drawTarget->h());
+  const uint8_t *alpha = _font->_atlas + glyph->_offset;
+
+  for (int j = y1; j < y2; j++) {
+    pixel_t *line = _drawTarget->getLine(j) + x1;
+    const uint8_t *row = alpha + (j - y) * glyph->_width + (x1 - x);
+    for (int i = 0; i < x2 - x1; i++) {
+      pixel_t a = row[i];
+      if (a == 255) {
+        line[i] = _drawColor;
+      } else if (a != 0) {
+        line[i] = blendChar(line[i], rb, ag, a);
       }
     }
   }
@@ -353,16 +390,14 @@ void Graphics::drawChar(FT_Bitmap *bitmap, FT_Int x, FT_Int y) const {
 
 void Graphics::drawText(int left, int top, const char *str, int len) const {
   if (_drawTarget && _font) {
-    FT_Vector pen;
-    pen.x = left;
-    pen.y = top + _font->_h + ((_font->_spacing - _font->_h) / 2);
+    pixel_t rb = _drawColor & 0x00ff00ff;
+    pixel_t ag = (_drawColor >> 8) & 0x00ff00ff;
+    int penX = left;
+    int penY = top + _font->_h + ((_font->_spacing - _font->_h) / 2);
     for (int i = 0; i < len; i++) {
-      uint8_t ch = str[i];
-      auto glyph = (FT_BitmapGlyph)_font->_glyph[ch]._slot;
-      drawChar(&glyph->bitmap,
-               pen.x + glyph->left,
-               pen.y - glyph->top);
-      pen.x += _font->_glyph[ch]._w;
+      const Glyph *glyph = &_font->_glyph[(uint8_t)str[i]];
+      drawChar(glyph, penX + glyph->_left, penY - glyph->_top, rb, ag);
+      penX += glyph->_w;
     }
   }
 }
@@ -415,9 +450,13 @@ MAExtent Graphics::getTextSize(const char *str, int len) const {
   int width = 0;
   int height = 0;
   if (_font) {
-    for (int i = 0; i < len; i++) {
-      uint8_t ch = str[i];
-      width += _font->_glyph[ch]._w;
+    if (_font->_fixedW) {
+      width = len * _font->_fixedW;
+    } else {
+      for (int i = 0; i < len; i++) {
+        uint8_t ch = str[i];
+        width += _font->_glyph[ch]._w;
+      }
     }
     height = _font->_spacing;
   }
@@ -24,9 +24,14 @@ using namespace strlib;
 
 namespace ui {
 
+// a glyph's bitmap is held in the font's atlas
 struct Glyph {
-  FT_Glyph _slot;
   int _w;
+  int _left;
+  int _top;
+  int _width;
+  int _rows;
+  int _offset;
 };
 
 struct Font {
@@ -34,7 +39,11 @@ struct Font {
   virtual ~Font();
   int _h;
   int _spacing;
+  // advance of every glyph in a fixed pitch font, otherwise 0
+  int _fixedW;
   FT_Face _face;
+  // coverage (alpha) of every glyph, pre-rasterised when the font is created
+  uint8_t *_atlas;
   Glyph _glyph[MAX_GLYPHS]{};
 };
 
@@ -68,7 +77,7 @@ struct Graphics {
   MAHandle setDrawTarget(MAHandle maHandle);
 
 protected:
-  void drawChar(FT_Bitmap *bitmap, FT_Int x, FT_Int y) const;
+  void drawChar(const Glyph *glyph, int x, int y, pixel_t rb, pixel_t ag) const;
   void aaLine(int x0, int y0, int x1, int y1) const;
   void aaPlot(int x, int y, double c) const;
   void aaPlotX8(int xc, int yc, int x, int y, double c, bool fill) const;